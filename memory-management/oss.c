@@ -26,6 +26,7 @@
 
 #include "list.h"
 #include "queue.h"
+#include "reaper.h"
 #include "shared.h"
 
 #define log _log
@@ -36,9 +37,16 @@ void simulate();
 void handleProcesses();
 void trySpawnProcess();
 void spawnProcess(int);
+pid_t forkUser(int);
+void createWorkerPool();
+void releaseWorkerPool();
+pid_t assignWorker(int);
+void releaseWorker(int);
 void initPCB(pid_t, int);
 int findAvailablePID();
 int advanceClock(int);
+void publishStats();
+void reapProcesses(bool);
 
 /* Program lifecycle functions */
 void init(int, char**);
@@ -67,7 +75,9 @@ static bool debug = false;
 static int shmid = -1;
 static int msqid = -1;
 static int semid = -1;
+static int statsid = -1;
 static System *system = NULL;
+static Stats *stats = NULL;
 static Message message;
 
 /* Simulation variables */
@@ -79,10 +89,18 @@ static Time nextSpawn;
 static int activeCount = 0;
 static int spawnCount = 0;
 static int exitCount = 0;
+static int exitPending = 0; /* User processes that said they're terminating but haven't been reaped */
+static Reaper reaper;
 static pid_t pids[PROCESSES_MAX];
+static bool pooled = false;
+static pid_t workers[PROCESSES_MAX]; /* Pre-forked user processes */
+static pid_t pool[PROCESSES_MAX]; /* Pre-forked user processes not assigned a simulated PID */
+static int poolSize = 0;
 static int memory[MAX_FRAMES];
+static int currentFrame = 0; /* Where the next-fit search for a free frame starts */
 static int memoryAccessCount = 0;
 static int pageFaultCount = 0;
+static int replacementCount = 0;
 static unsigned int totalAccessTime = 0;
 
 int main(int argc, char *argv[]) {
@@ -94,7 +112,7 @@ int main(int argc, char *argv[]) {
 
 	/* Get program arguments */
 	while (true) {
-		int c = getopt(argc, argv, "hm:d");
+		int c = getopt(argc, argv, "hm:dw");
 		if (c == -1) break;
 		switch (c) {
 			case 'h':
@@ -109,6 +127,9 @@ int main(int argc, char *argv[]) {
 			case 'd':
 				debug = true;
 				break;
+			case 'w':
+				pooled = true;
+				break;
 			default:
 				ok = false;
 		}
@@ -137,6 +158,7 @@ int main(int argc, char *argv[]) {
 
 	/* Setup simulation */
 	initIPC();
+	if (!reaper_open(&reaper)) crash("reaper_open");
 	memset(pids, 0, sizeof(pids));
 	system->clock.s = 0;
 	system->clock.ns = 0;
@@ -146,13 +168,17 @@ int main(int argc, char *argv[]) {
 	queue = queue_create();
 	reference = list_create();
 	stack = list_create();
+	if (pooled) createWorkerPool();
 
 	/* Start simulating */
 	simulate();
+	publishStats();
 
 	printSummary();
 
 	/* Cleanup resources */
+	releaseWorkerPool();
+	reaper_close(&reaper);
 	freeIPC();
 
 	return ok ? EXIT_SUCCESS  : EXIT_FAILURE;
@@ -183,15 +209,8 @@ void simulate() {
 		handleProcesses();
 		advanceClock(0);
 
-		/* Catch an exited user process */
-		int status;
-		pid_t pid = waitpid(-1, &status, WNOHANG);
-		if (pid > 0) {
-			int spid = WEXITSTATUS(status);
-			pids[spid] = 0;
-			activeCount--;
-			exitCount++;
-		}
+		/* Only look for exited user processes once one has said it's terminating, and sleep if that's all that's left */
+		if (exitPending > 0) reapProcesses(exitPending == activeCount && (quit || spawnCount >= PROCESSES_TOTAL));
 
 		/* Stop simulating if the last user process has exited */
 		if (quit) {
@@ -216,10 +235,10 @@ void handleProcesses() {
 		message.type = system->ptable[spid].pid;
 		message.spid = spid;
 		message.pid = system->ptable[spid].pid;
-		msgsnd(msqid, &message, sizeof(Message), 0);
+		msgsnd(msqid, &message, MESSAGE_SIZE, 0);
 
 		/* Receive a response of what they're doing */
-		msgrcv(msqid, &message, sizeof(Message), 1, 0);
+		msgrcv(msqid, &message, MESSAGE_SIZE, 1, 0);
 
 		advanceClock(0);
 
@@ -233,12 +252,16 @@ void handleProcesses() {
 			for (i = 0; i < MAX_PAGES; i++) {
 				if (system->ptable[spid].ptable[i].frame != -1) {
 					int frame = system->ptable[spid].ptable[i].frame;
+					if (frame < 0 || frame >= MAX_FRAMES) crash("frame out of range");
 					list_remove(reference, spid, i, frame);
 					memory[frame / 8] &= ~(1 << (frame % 8));
 				}
 			}
+
+			/* A pooled user process goes back to waiting for a new simulated PID instead of exiting */
+			if (pooled) releaseWorker(spid);
+			else exitPending++;
 		} else {
-			int currentFrame;
 			totalAccessTime += advanceClock(1000000);
 			queue_push(temp, spid);
 			
@@ -267,6 +290,7 @@ void handleProcesses() {
 				int frameCount = 0;
 				while (true) {
 					currentFrame = (currentFrame + 1) % MAX_FRAMES;
+					if (currentFrame < 0 || currentFrame >= MAX_FRAMES) crash("frame out of range");
 					if ((memory[currentFrame / 8] & (1 << (currentFrame % 8))) == 0) {
 						isMemoryOpen = true;
 						break;
@@ -310,6 +334,7 @@ void handleProcesses() {
 					}
 
 					/* Page replacement */
+					replacementCount++;
 					system->ptable[index].ptable[page].frame = -1;
 					system->ptable[index].ptable[page].dirty = 0;
 					system->ptable[index].ptable[page].valid = 0;
@@ -323,7 +348,7 @@ void handleProcesses() {
 					
 					if (system->ptable[spid].ptable[requestedPage].protection == 1) {
 						system->ptable[spid].ptable[requestedPage].dirty = 1;
-						flog("Dirty bit of frame %d set, adding additional time to the clock\n", currentFrame);
+						flog("Dirty bit of frame %d set, adding additional time to the clock\n", frame);
 					}
 				}
 			} else {
@@ -341,6 +366,7 @@ void handleProcesses() {
 		}
 		
 		displayMemoryMap();
+		publishStats();
 		
 		/* Reset message */
 		message.type = -1;
@@ -387,12 +413,26 @@ void trySpawnProcess() {
 }
 
 void spawnProcess(int spid) {
-	/* Fork a new user process */
-	pid_t pid = fork();
+	/* Hand the simulated PID to an idle pre-forked user process, or fork a new one */
+	pid_t pid = pooled ? assignWorker(spid) : forkUser(spid);
 	
 	/* Record its PID */
 	pids[spid] = pid;
 
+	/* Since parent, initialize the new user process for simulation */
+	initPCB(pid, spid);
+	queue_push(queue, spid);
+	activeCount++;
+	spawnCount++;
+
+	flog("p%d created\n", spid);
+}
+
+/* Forks and executes a user process for the simulated PID, or a pooled user process if -1 */
+pid_t forkUser(int spid) {
+	/* Fork a new user process */
+	pid_t pid = fork();
+
 	if (pid == -1) crash("fork");
 	else if (pid == 0) {
 		/* Since child, execute a new user process */
@@ -400,17 +440,60 @@ void spawnProcess(int spid) {
 		char arg1[BUFFER_LENGTH];
 		sprintf(arg0, "%d", spid);
 		sprintf(arg1, "%d", scheme);
+		reaper_child(&reaper);
 		execl("./user", "user", arg0, arg1, (char*) NULL);
 		crash("execl");
 	}
 
-	/* Since parent, initialize the new user process for simulation */
-	initPCB(pid, spid);
-	queue_push(queue, spid);
-	activeCount++;
-	spawnCount++;
+	return pid;
+}
 
-	flog("p%d created\n", spid);
+/* Forks every user process once, up front, so none are forked per simulated process */
+void createWorkerPool() {
+	int i;
+	for (i = 0; i < PROCESSES_MAX; i++) {
+		workers[i] = forkUser(-1);
+		pool[poolSize++] = workers[i];
+	}
+}
+
+void releaseWorkerPool() {
+	bool sent[PROCESSES_MAX] = { false };
+	int i, j;
+
+	if (!pooled) return;
+
+	/* A simulated PID of -1 tells an idle pooled user process to exit */
+	for (i = 0; i < poolSize; i++) {
+		message.type = pool[i];
+		message.spid = -1;
+		if (msgsnd(msqid, &message, MESSAGE_SIZE, 0) == -1) continue;
+		for (j = 0; j < PROCESSES_MAX; j++)
+			if (workers[j] == pool[i]) sent[j] = true;
+	}
+	poolSize = 0;
+
+	/* Only wait for the ones told to exit, since the rest would never read a sentinel */
+	for (i = 0; i < PROCESSES_MAX; i++)
+		if (sent[i]) waitpid(workers[i], NULL, 0);
+}
+
+/* Sends an idle pooled user process the simulated PID it will now run as */
+pid_t assignWorker(int spid) {
+	pid_t pid = pool[--poolSize];
+	message.type = pid;
+	message.spid = spid;
+	message.pid = pid;
+	msgsnd(msqid, &message, MESSAGE_SIZE, 0);
+	return pid;
+}
+
+/* Returns a terminated simulated process' user process to the pool */
+void releaseWorker(int spid) {
+	pool[poolSize++] = pids[spid];
+	pids[spid] = 0;
+	activeCount--;
+	exitCount++;
 }
 
 void initPCB(pid_t pid, int spid) {
@@ -452,6 +535,42 @@ int advanceClock(int ns) {
 	return r;
 }
 
+/* Reaps every user process that has exited, which SIGCHLD wakes us for, waiting for one first if asked to */
+void reapProcesses(bool wait) {
+	if (!reaper_wait(&reaper, wait ? -1 : 0)) return;
+	
+	int status;
+	pid_t pid;
+	while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+		int spid = WEXITSTATUS(status);
+		pids[spid] = 0;
+		activeCount--;
+		exitCount++;
+		exitPending--;
+	}
+	publishStats();
+}
+
+/* Copies the counters onto the stats page without ever waiting on ossstat, which retries if it reads mid-update */
+void publishStats() {
+	__atomic_store_n(&stats->sequence, stats->sequence + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	stats->clock = system->clock;
+	stats->spawned = spawnCount;
+	stats->exited = exitCount;
+	stats->active = activeCount;
+	stats->accesses = memoryAccessCount;
+	stats->faults = pageFaultCount;
+	stats->replacements = replacementCount;
+	stats->frames = 0;
+	int i;
+	for (i = 0; i < MAX_FRAMES / 8; i++)
+		stats->frames += __builtin_popcount(memory[i]);
+
+	__atomic_store_n(&stats->sequence, stats->sequence + 1, __ATOMIC_RELEASE);
+}
+
 void init(int argc, char **argv)
 {
 	programName = argv[0];
@@ -463,9 +582,10 @@ void init(int argc, char **argv)
 void usage(int status) {
 	if (status != EXIT_SUCCESS) fprintf(stderr, "Try '%s -h' for more information\n", programName);
 	else {
-		printf("Usage: %s [-m x] [-d]\n", programName);
+		printf("Usage: %s [-m x] [-d] [-w]\n", programName);
 		printf("     -m x     : Request scheme (1 = RANDOM, 2 = WEIGHTED) (default 1)\n");
 		printf("     -d       : Debug mode (default off)\n");
+		printf("     -w       : Pre-fork a pool of reusable user processes (default off)\n");
 	}
 	exit(status);
 }
@@ -500,6 +620,11 @@ void signalHandler(int sig) {
 		int i;
 		for (i = 0; i < PROCESSES_MAX; i++)
 			if (pids[i] > 0) kill(pids[i], SIGTERM);
+		
+		/* Idle pooled user processes have no simulated PID, but would keep wait from returning */
+		if (pooled)
+			for (i = 0; i < PROCESSES_MAX; i++)
+				if (workers[i] > 0) kill(workers[i], SIGTERM);
 		while (wait(NULL) > 0);
 
 		freeIPC();
@@ -529,9 +654,23 @@ void initIPC() {
 	if ((key = ftok(KEY_PATHNAME, KEY_ID_SEMAPHORE)) == -1) crash("ftok");
 	if ((semid = semget(key, 1, IPC_EXCL | IPC_CREAT | PERMS)) == -1) crash("semget");
 	if (semctl(semid, 0, SETVAL, 1) == -1) crash("semctl");
+
+	if ((key = ftok(KEY_PATHNAME, KEY_ID_STATS)) == -1) crash("ftok");
+	if ((statsid = shmget(key, sizeof(Stats), IPC_EXCL | IPC_CREAT | PERMS)) == -1) crash("shmget");
+	if ((stats = (Stats*) shmat(statsid, NULL, 0)) == (void*) -1) crash("shmat");
+	memset(stats, 0, sizeof(Stats));
+	stats->version = STATS_VERSION;
 }
 
 void freeIPC() {
+	/* Let ossstat know nothing more is coming before the page goes away */
+	if (stats != NULL) {
+		__atomic_store_n(&stats->finished, true, __ATOMIC_RELEASE);
+		if (shmdt(stats) == -1) crash("shmdt");
+		stats = NULL;
+	}
+	if (statsid > 0 && shmctl(statsid, IPC_RMID, NULL) == -1) crash("shmctl");
+
 	if (system != NULL && shmdt(system) == -1) crash("shmdt");
 	if (shmid > 0 && shmctl(shmid, IPC_RMID, NULL) == -1) crash("shmdt");
 
@@ -0,0 +1,24 @@
+/*
+ * reaper.h December 2, 2020
+ * Jared Diehl (jmddnb@umsystem.edu)
+ */
+
+#ifndef REAPER_H
+#define REAPER_H
+
+#include <signal.h>
+#include <stdbool.h>
+
+/* SIGCHLD delivered through a signalfd in an epoll set, so exited children are only looked for once one has exited */
+typedef struct {
+	int epfd;
+	int sigfd;
+	sigset_t previous; /* Signal mask from before SIGCHLD was blocked, which forked children get back */
+} Reaper;
+
+bool reaper_open(Reaper*);
+bool reaper_wait(Reaper*, int);
+void reaper_child(Reaper*);
+void reaper_close(Reaper*);
+
+#endif
@@ -18,9 +18,11 @@
 #define KEY_ID_SYSTEM 0
 #define KEY_ID_MESSAGE_QUEUE 1
 #define KEY_ID_SEMAPHORE 2
+#define KEY_ID_STATS 3
 #define PERMS (S_IRUSR | S_IWUSR)
 
 #define PATH_LOG "output.log"
+#define STATS_VERSION 1
 #define TIMEOUT 2
 #define PROCESSES_MAX 18
 #define PROCESSES_TOTAL 40
@@ -53,6 +55,9 @@ typedef struct {
 	unsigned int page;
 } Message;
 
+/* Size of a message minus its type, which is what msgsnd and msgrcv expect */
+#define MESSAGE_SIZE (sizeof(Message) - sizeof(long))
+
 typedef struct {
 	uint frame;
 	uint address: 8;
@@ -72,4 +77,19 @@ typedef struct {
 	PCB ptable[PROCESSES_MAX];
 } System;
 
+/* Counters OSS publishes for ossstat, guarded by a sequence that's odd while OSS is writing */
+typedef struct {
+	unsigned int version;
+	unsigned int sequence;
+	bool finished;
+	Time clock;
+	unsigned int spawned;
+	unsigned int exited;
+	unsigned int active;
+	unsigned int accesses;
+	unsigned int faults;
+	unsigned int replacements;
+	unsigned int frames; /* Frames in use */
+} Stats;
+
 #endif
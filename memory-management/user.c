@@ -24,6 +24,7 @@
 #include "shared.h"
 
 void init(int, char**);
+void simulate(int, int);
 void initIPC();
 void crash(char*);
 
@@ -45,6 +46,24 @@ int main(int argc, char *argv[]) {
 
 	initIPC();
 
+	/* Run as the given simulated PID, or as a pooled user process if -1 */
+	if (spid != -1) {
+		simulate(spid, scheme);
+		return spid;
+	}
+
+	while (true) {
+		/* Wait until OSS assigns us a simulated PID, where -1 means we're no longer needed */
+		msgrcv(msqid, &message, MESSAGE_SIZE, getpid(), 0);
+		if (message.spid == -1) break;
+		simulate(message.spid, scheme);
+	}
+
+	return EXIT_SUCCESS;
+}
+
+/* Runs the decision loop as a simulated process until it terminates */
+void simulate(int spid, int scheme) {
 	bool terminate = false;
 	int referenceCount = 0;
 	unsigned int address = 0;
@@ -53,7 +72,7 @@ int main(int argc, char *argv[]) {
 	/* Decision loop */
 	while (true) {
 		/* Wait until we get a message from OSS telling us it's our turn to "run" */
-		msgrcv(msqid, &message, sizeof(Message), getpid(), 0);
+		msgrcv(msqid, &message, MESSAGE_SIZE, getpid(), 0);
 
 		/* Continue getting address if we haven't referenced to our limit (1000) */
 		if (referenceCount <= 1000) {
@@ -99,12 +118,10 @@ int main(int argc, char *argv[]) {
 		message.terminate = terminate;
 		message.address = address;
 		message.page = page;
-		msgsnd(msqid, &message, sizeof(Message), 0);
+		msgsnd(msqid, &message, MESSAGE_SIZE, 0);
 
 		if (terminate) break;
 	}
-
-	return spid;
 }
 
 void init(int argc, char **argv) {
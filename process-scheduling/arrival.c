@@ -0,0 +1,148 @@
+/*
+ * arrival.c 11/9/20
+ * Jared Diehl (jmddnb@umsystem.edu)
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "arrival.h"
+
+typedef struct {
+	char *name;
+	int type;
+	int params;
+} ArrivalModel;
+
+static ArrivalModel models[] = {
+	{ "uniform", ARRIVAL_UNIFORM, 0 },
+	{ "poisson", ARRIVAL_POISSON, 1 }, /* rate */
+	{ "fixed", ARRIVAL_FIXED, 1 }, /* rate */
+	{ "mmpp", ARRIVAL_MMPP, 4 }, /* rate, rate, sojourn, sojourn */
+	{ "onoff", ARRIVAL_MMPP, 3 }, /* rate, on sojourn, off sojourn */
+	{ "diurnal", ARRIVAL_DIURNAL, 3 }, /* mean rate, amplitude, period */
+	{ NULL, 0, 0 }
+};
+
+/* Uniform in (0, 1], so it's always safe to take the log of */
+static double uniform() {
+	return (rand() + 1.0) / (RAND_MAX + 1.0);
+}
+
+/* Nanoseconds until the next event of a Poisson process with the given mean time in seconds between events */
+static long exponential(double mean) {
+	return (long) (-log(uniform()) * mean * 1e9);
+}
+
+static double diurnalRate(Arrival *arrival, long time) {
+	return arrival->rates[0] * (1 + arrival->amplitude * sin(2 * M_PI * (time / 1e9) / arrival->period));
+}
+
+/* Sets up the arrival process from a spec such as "poisson:2.5", returning false if it's invalid */
+bool arrival_init(Arrival *arrival, char *spec) {
+	char buf[strlen(spec) + 1];
+	strcpy(buf, spec);
+	
+	char *name = strtok(buf, ":");
+	if (name == NULL) return false;
+	
+	ArrivalModel *model;
+	for (model = models; model->name != NULL; model++)
+		if (strcmp(model->name, name) == 0) break;
+	if (model->name == NULL) return false;
+	
+	double params[ARRIVAL_PARAMS_MAX];
+	int count = 0;
+	char *token, *end;
+	while ((token = strtok(NULL, ",")) != NULL) {
+		if (count == ARRIVAL_PARAMS_MAX) return false;
+		params[count++] = strtod(token, &end);
+		if (end == token || *end != '\0' || params[count - 1] < 0) return false;
+	}
+	if (count != model->params) return false;
+	
+	memset(arrival, 0, sizeof(Arrival));
+	arrival->type = model->type;
+	arrival->until = -1;
+	
+	switch (arrival->type) {
+		case ARRIVAL_POISSON:
+		case ARRIVAL_FIXED:
+			arrival->rates[0] = params[0];
+			return arrival->rates[0] > 0;
+		case ARRIVAL_MMPP:
+			/* On/off is just an mmpp that never has an arrival in its second state */
+			if (count == 3) {
+				params[3] = params[2];
+				params[2] = params[1];
+				params[1] = 0;
+			}
+			arrival->rates[0] = params[0];
+			arrival->rates[1] = params[1];
+			arrival->sojourns[0] = params[2];
+			arrival->sojourns[1] = params[3];
+			return arrival->rates[0] + arrival->rates[1] > 0 && arrival->sojourns[0] > 0 && arrival->sojourns[1] > 0;
+		case ARRIVAL_DIURNAL:
+			arrival->rates[0] = params[0];
+			arrival->amplitude = params[1];
+			arrival->period = params[2];
+			return arrival->rates[0] > 0 && arrival->amplitude <= 1 && arrival->period > 0;
+	}
+	
+	return true;
+}
+
+/* Returns the nanosecond of the first arrival after the given one */
+long arrival_next(Arrival *arrival, long now) {
+	long next;
+	
+	switch (arrival->type) {
+		case ARRIVAL_POISSON:
+			return now + exponential(1 / arrival->rates[0]);
+		case ARRIVAL_FIXED:
+			return now + (long) (1e9 / arrival->rates[0]);
+		case ARRIVAL_MMPP:
+			/* Catch up on any state changes while a spawn was put off */
+			if (arrival->until == -1) arrival->until = now + exponential(arrival->sojourns[0]);
+			while (arrival->until <= now) {
+				arrival->state ^= 1;
+				arrival->until += exponential(arrival->sojourns[arrival->state]);
+			}
+			
+			/* Both states are memoryless, so an arrival that would land past a state change is just redrawn from it */
+			while (true) {
+				if (arrival->rates[arrival->state] > 0) {
+					next = now + exponential(1 / arrival->rates[arrival->state]);
+					if (next < arrival->until) return next;
+				}
+				now = arrival->until;
+				arrival->state ^= 1;
+				arrival->until += exponential(arrival->sojourns[arrival->state]);
+			}
+		case ARRIVAL_DIURNAL:
+			/* Thinning: draw at the peak rate and keep each arrival with the odds the rate at that time gives it */
+			next = now;
+			double peak = arrival->rates[0] * (1 + arrival->amplitude);
+			do next += exponential(1 / peak);
+			while (uniform() * peak > diurnalRate(arrival, next));
+			return next;
+		default:
+			next = (long) (rand() % (MAX_TIME_BETWEEN_NEW_PROCS_SEC + 1)) * 1000000000;
+			return now + next + rand() % (MAX_TIME_BETWEEN_NEW_PROCS_NS + 1);
+	}
+}
+
+/* Long-run mean arrivals per simulated second */
+double arrival_rate(Arrival *arrival) {
+	switch (arrival->type) {
+		case ARRIVAL_POISSON:
+		case ARRIVAL_FIXED:
+		case ARRIVAL_DIURNAL:
+			return arrival->rates[0];
+		case ARRIVAL_MMPP:
+			return (arrival->rates[0] * arrival->sojourns[0] + arrival->rates[1] * arrival->sojourns[1]) / (arrival->sojourns[0] + arrival->sojourns[1]);
+		default:
+			return 1e9 / (MAX_TIME_BETWEEN_NEW_PROCS_SEC * 1e9 / 2 + MAX_TIME_BETWEEN_NEW_PROCS_NS / 2.0);
+	}
+}
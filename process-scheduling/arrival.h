@@ -0,0 +1,34 @@
+/*
+ * arrival.h 11/9/20
+ * Jared Diehl (jmddnb@umsystem.edu)
+ */
+
+#ifndef ARRIVAL_H
+#define ARRIVAL_H
+
+#include <stdbool.h>
+
+/* Bounds of the default uniform time between new processes */
+#define MAX_TIME_BETWEEN_NEW_PROCS_SEC 1
+#define MAX_TIME_BETWEEN_NEW_PROCS_NS 15000
+
+#define ARRIVAL_PARAMS_MAX 4
+
+enum ArrivalType { ARRIVAL_UNIFORM, ARRIVAL_POISSON, ARRIVAL_FIXED, ARRIVAL_MMPP, ARRIVAL_DIURNAL };
+
+/* Process that decides when new processes arrive, where rates are per simulated second and times in seconds */
+typedef struct {
+	int type;
+	double rates[2]; /* Arrival rate in each state of an mmpp, or the only (mean) rate otherwise */
+	double sojourns[2]; /* Mean time an mmpp stays in each state */
+	double amplitude; /* Fraction of the mean a diurnal rate swings above and below it */
+	double period; /* Time a diurnal rate takes to go through one cycle */
+	int state; /* Current state of an mmpp */
+	long until; /* Nanosecond an mmpp leaves its current state, or -1 before its first arrival */
+} Arrival;
+
+bool arrival_init(Arrival*, char*);
+long arrival_next(Arrival*, long);
+double arrival_rate(Arrival*);
+
+#endif
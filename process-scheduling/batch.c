@@ -0,0 +1,131 @@
+/*
+ * batch.c 11/9/20
+ * Jared Diehl (jmddnb@umsystem.edu)
+ */
+
+#include <stdlib.h>
+
+#include "batch.h"
+
+/*
+ * EASY backfilling. Jobs start in the order they were submitted for as long as they fit. Once the head of the queue
+ * doesn't, it gets a reservation for the earliest time enough running jobs are expected to have ended, and any later
+ * job that fits now can jump ahead as long as it doesn't push that reservation back: either it's expected to end
+ * before then, or it only uses processors the head won't need even then.
+ */
+
+static bool endsBefore(RBNode *a, RBNode *b) {
+	return ((BatchJob*) a)->end < ((BatchJob*) b)->end;
+}
+
+static unsigned long getSum(RBNode *node) {
+	return node == NULL ? 0 : ((BatchJob*) node)->sum;
+}
+
+static void updateSum(RBNode *node) {
+	((BatchJob*) node)->sum = ((BatchJob*) node)->width + getSum(node->left) + getSum(node->right);
+}
+
+static void start(Batch *batch, BatchJob *job, long now) {
+	job->start = now;
+	job->end = now + job->estimate;
+	rbtree_insert(&batch->timeline, &job->node);
+	batch->free -= job->width;
+}
+
+/*
+ * Walks down the timeline to the first running job whose end frees up enough processors, counting what the jobs
+ * ending before it free up from the sums of their subtrees, so it only takes one path from the root. Sets when that
+ * is and how many processors will be left over then.
+ */
+static void reserve(Batch *batch, unsigned int width, long now, long *shadow, unsigned int *extra) {
+	RBNode *node = batch->timeline.root;
+	unsigned long freed = batch->free;
+	
+	while (node != NULL) {
+		BatchJob *job = (BatchJob*) node;
+		unsigned long before = freed + getSum(node->left);
+		if (before >= width) node = node->left;
+		else if (before + job->width >= width) {
+			*shadow = job->end > now ? job->end : now;
+			*extra = before + job->width - width;
+			return;
+		} else {
+			freed = before + job->width;
+			node = node->right;
+		}
+	}
+	
+	/* Only if the job is wider than the machine, which the caller never submits */
+	*shadow = now;
+	*extra = 0;
+}
+
+Batch *batch_create(unsigned int size) {
+	Batch *batch = (Batch*) calloc(1, sizeof(Batch));
+	batch->size = batch->free = size;
+	rbtree_initialize(&batch->timeline, endsBefore);
+	rbtree_augment(&batch->timeline, updateSum);
+	return batch;
+}
+
+void batch_submit(Batch *batch, BatchJob *job) {
+	job->next = NULL;
+	if (batch->tail == NULL) batch->head = job;
+	else batch->tail->next = job;
+	batch->tail = job;
+	batch->queued++;
+}
+
+/* Starts whatever can start now, returning the jobs it started linked through next */
+BatchJob *batch_schedule(Batch *batch, long now) {
+	BatchJob *started = NULL, **last = &started;
+	
+	while (batch->head != NULL && batch->head->width <= batch->free) {
+		BatchJob *job = batch->head;
+		batch->head = job->next;
+		if (batch->head == NULL) batch->tail = NULL;
+		batch->queued--;
+		start(batch, job, now);
+		*last = job;
+		last = &job->next;
+	}
+	*last = NULL;
+	if (batch->head == NULL || batch->free == 0) return started;
+	
+	long shadow;
+	unsigned int extra;
+	reserve(batch, batch->head->width, now, &shadow, &extra);
+	
+	/* Each job behind the head is checked once against the reservation, which doesn't move while backfilling */
+	BatchJob *previous = batch->head, *job = previous->next;
+	while (job != NULL && batch->free > 0) {
+		bool early = now + job->estimate <= shadow;
+		if (job->width > batch->free || (!early && job->width > extra)) {
+			previous = job;
+			job = job->next;
+			continue;
+		}
+		
+		previous->next = job->next;
+		if (batch->tail == job) batch->tail = previous;
+		batch->queued--;
+		
+		/* A job still running at the reservation uses up processors the head didn't need */
+		if (!early) extra -= job->width;
+		
+		start(batch, job, now);
+		batch->backfilled++;
+		*last = job;
+		last = &job->next;
+		job = previous->next;
+	}
+	*last = NULL;
+	
+	return started;
+}
+
+void batch_finish(Batch *batch, BatchJob *job) {
+	rbtree_erase(&batch->timeline, &job->node);
+	batch->free += job->width;
+}
@@ -0,0 +1,40 @@
+/*
+ * batch.h 11/9/20
+ * Jared Diehl (jmddnb@umsystem.edu)
+ */
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "rbtree.h"
+
+/* Rigid job that holds its processors from when it starts until it finishes, where times are in nanoseconds */
+typedef struct BatchJob {
+	RBNode node; /* In the timeline while running, ordered by estimated end */
+	unsigned int width; /* Processors it runs on */
+	unsigned long sum; /* Widths of every job in its subtree of the timeline */
+	long submit;
+	long run;
+	long estimate; /* Run time it declared, never less than the actual one */
+	long start;
+	long end; /* Estimated end, from its start and estimate */
+	unsigned int slot; /* Where OSS keeps it while it runs */
+	struct BatchJob *next; /* Next queued job, or next job started at the same time */
+} BatchJob;
+
+/* EASY backfilling over a machine of identical processors */
+typedef struct {
+	unsigned int size;
+	unsigned int free;
+	BatchJob *head, *tail; /* Jobs waiting to start, in the order they were submitted */
+	unsigned int queued;
+	RBTree timeline; /* Running jobs, which is when processors are expected to free up */
+	unsigned long backfilled; /* Jobs started ahead of the head of the queue */
+} Batch;
+
+Batch *batch_create(unsigned int);
+void batch_submit(Batch*, BatchJob*);
+BatchJob *batch_schedule(Batch*, long);
+void batch_finish(Batch*, BatchJob*);
+
+#endif
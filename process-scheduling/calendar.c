@@ -0,0 +1,102 @@
+/*
+ * calendar.c 11/9/20
+ * Jared Diehl (jmddnb@umsystem.edu)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "calendar.h"
+
+static bool before(Event *a, Event *b) {
+	int n = compareTime(&a->time, &b->time);
+	return n < 0 || (n == 0 && a->sequence < b->sequence);
+}
+
+static void swap(Event *a, Event *b) {
+	Event temp = *a;
+	*a = *b;
+	*b = temp;
+}
+
+static void siftUp(Calendar *calendar, unsigned int i) {
+	while (i > 0) {
+		unsigned int parent = (i - 1) / 2;
+		if (!before(&calendar->array[i], &calendar->array[parent])) break;
+		swap(&calendar->array[i], &calendar->array[parent]);
+		i = parent;
+	}
+}
+
+static void siftDown(Calendar *calendar, unsigned int i) {
+	while (true) {
+		unsigned int left = 2 * i + 1, right = left + 1, min = i;
+		if (left < calendar->size && before(&calendar->array[left], &calendar->array[min])) min = left;
+		if (right < calendar->size && before(&calendar->array[right], &calendar->array[min])) min = right;
+		if (min == i) break;
+		swap(&calendar->array[i], &calendar->array[min]);
+		i = min;
+	}
+}
+
+Calendar *calendar_create(unsigned int capacity) {
+	Calendar *calendar = (Calendar*) malloc(sizeof(Calendar));
+	calendar->size = 0;
+	calendar->capacity = capacity;
+	calendar->sequence = 0;
+	calendar->array = (Event*) malloc(calendar->capacity * sizeof(Event));
+	return calendar;
+}
+
+void calendar_push(Calendar *calendar, int type, Time *time, unsigned int localPID) {
+	/* Grow the heap instead of dropping events */
+	if (calendar->size == calendar->capacity) {
+		calendar->capacity *= 2;
+		calendar->array = (Event*) realloc(calendar->array, calendar->capacity * sizeof(Event));
+	}
+
+	unsigned int i = calendar->size++;
+	Event *event = &calendar->array[i];
+	copyTime(time, &event->time);
+	event->sequence = calendar->sequence++;
+	event->type = type;
+	event->localPID = localPID;
+
+	siftUp(calendar, i);
+}
+
+bool calendar_pop(Calendar *calendar, Event *event) {
+	if (calendar_empty(calendar)) return false;
+
+	*event = calendar->array[0];
+	calendar->array[0] = calendar->array[--calendar->size];
+	siftDown(calendar, 0);
+
+	return true;
+}
+
+/* Takes out the first event found for the local PID, returning whether there was one */
+bool calendar_remove(Calendar *calendar, unsigned int localPID) {
+	unsigned int i;
+	for (i = 0; i < calendar->size; i++)
+		if (calendar->array[i].localPID == localPID) break;
+	if (i == calendar->size) return false;
+
+	/* The last event fills the hole, then moves whichever way restores the heap */
+	calendar->array[i] = calendar->array[--calendar->size];
+	if (i < calendar->size) {
+		siftUp(calendar, i);
+		siftDown(calendar, i);
+	}
+	return true;
+}
+
+Event *calendar_peek(Calendar *calendar) {
+	if (calendar_empty(calendar)) return NULL;
+	return &calendar->array[0];
+}
+
+bool calendar_empty(Calendar *calendar) {
+	return calendar->size == 0;
+}
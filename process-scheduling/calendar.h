@@ -0,0 +1,35 @@
+/*
+ * calendar.h 11/9/20
+ * Jared Diehl (jmddnb@umsystem.edu)
+ */
+
+#ifndef CALENDAR_H
+#define CALENDAR_H
+
+#include <stdbool.h>
+
+#include "shared.h"
+
+typedef struct {
+	Time time; /* Time the event fires */
+	unsigned long sequence; /* Insertion order, breaks ties between equal times */
+	int type;
+	unsigned int localPID;
+} Event;
+
+/* Min-heap of events ordered by time */
+typedef struct {
+	unsigned int size;
+	unsigned int capacity;
+	unsigned long sequence;
+	Event *array;
+} Calendar;
+
+Calendar *calendar_create(unsigned int);
+void calendar_push(Calendar*, int, Time*, unsigned int);
+bool calendar_pop(Calendar*, Event*);
+bool calendar_remove(Calendar*, unsigned int);
+Event *calendar_peek(Calendar*);
+bool calendar_empty(Calendar*);
+
+#endif
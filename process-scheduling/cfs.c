@@ -0,0 +1,156 @@
+/*
+ * cfs.c 11/9/20
+ * Jared Diehl (jmddnb@umsystem.edu)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "rbtree.h"
+#include "scheduler.h"
+
+/* Every runnable process should get a turn within this long */
+#define CFS_LATENCY (QUANTUM_BASE * 2)
+/* Shortest slice handed out, however many processes are runnable */
+#define CFS_GRANULARITY (QUANTUM_BASE / 4)
+
+#define CFS_WEIGHT_NORMAL 1024
+
+/*
+ * Completely fair scheduler. Runnable processes are kept in a red-black tree ordered by virtual runtime, which is
+ * CPU time scaled down by the process' weight, and the one that has had the least of it runs next. Every CPU has
+ * its own tree, and virtual runtimes are only comparable within one.
+ */
+
+typedef struct {
+	RBNode node;
+	unsigned int localPID;
+	long vruntime;
+} Entity;
+
+typedef struct {
+	RBTree tree;
+	long minVruntime; /* Never goes backwards, so sleepers can't bank runtime */
+	long load; /* Total weight of the processes in the tree */
+} CfsQueue;
+
+static CfsQueue *queues; /* Indexed by CPU */
+static Entity *entities; /* Indexed by local PID */
+static unsigned int queued[QUEUE_SET_COUNT]; /* Processes in every tree, by priority */
+
+static bool less(RBNode *a, RBNode *b) {
+	return ((Entity*) a)->vruntime < ((Entity*) b)->vruntime;
+}
+
+/* Real-time processes always go to the EDF class, so every process here is normal */
+static long getWeight(PCB *pcb) {
+	return CFS_WEIGHT_NORMAL;
+}
+
+static void insert(PCB *pcb) {
+	Entity *entity = &entities[pcb->localPID];
+	entity->localPID = pcb->localPID;
+	rbtree_insert(&queues[pcb->processor].tree, &entity->node);
+	queues[pcb->processor].load += getWeight(pcb);
+	queued[pcb->priority]++;
+}
+
+static void charge(PCB *pcb, long used) {
+	entities[pcb->localPID].vruntime += used * CFS_WEIGHT_NORMAL / getWeight(pcb);
+}
+
+static void initialize(unsigned int cpus, unsigned int concurrency) {
+	queues = (CfsQueue*) calloc(cpus, sizeof(CfsQueue));
+	entities = (Entity*) calloc(concurrency + 1, sizeof(Entity));
+	
+	unsigned int i;
+	for (i = 0; i < cpus; i++) rbtree_initialize(&queues[i].tree, less);
+}
+
+/* A new process starts level with the least-run process so it neither starves nor hogs the CPU */
+static void enqueue(PCB *pcb) {
+	entities[pcb->localPID].vruntime = queues[pcb->processor].minVruntime;
+	insert(pcb);
+}
+
+static void dequeue(PCB *pcb) {
+	rbtree_erase(&queues[pcb->processor].tree, &entities[pcb->localPID].node);
+	queues[pcb->processor].load -= getWeight(pcb);
+	queued[pcb->priority]--;
+}
+
+/* The CPU's minimum follows whichever process it runs next */
+static PCB *run(Entity *entity, unsigned int cpu) {
+	if (entity->vruntime > queues[cpu].minVruntime) queues[cpu].minVruntime = entity->vruntime;
+	return &getSharedMemory()->ptable[entity->localPID];
+}
+
+static PCB *pickNext(unsigned int cpu) {
+	Entity *entity = (Entity*) rbtree_first(&queues[cpu].tree);
+	if (entity == NULL) return NULL;
+	dequeue(&getSharedMemory()->ptable[entity->localPID]);
+	return run(entity, cpu);
+}
+
+/* Takes the process furthest from a turn, moving its virtual runtime over relative to each CPU's minimum */
+static PCB *steal(unsigned int from, unsigned int to) {
+	Entity *entity = (Entity*) rbtree_last(&queues[from].tree);
+	if (entity == NULL) return NULL;
+	dequeue(&getSharedMemory()->ptable[entity->localPID]);
+	entity->vruntime += queues[to].minVruntime - queues[from].minVruntime;
+	return run(entity, to);
+}
+
+static unsigned int load(unsigned int cpu) {
+	return queues[cpu].tree.size;
+}
+
+static unsigned int depth(unsigned int priority) {
+	return queued[priority];
+}
+
+/* Splits the latency between runnable processes by weight */
+static int quantum(PCB *pcb) {
+	long weight = getWeight(pcb);
+	long slice = CFS_LATENCY * weight / (queues[pcb->processor].load + weight);
+	return slice < CFS_GRANULARITY ? CFS_GRANULARITY : slice;
+}
+
+static void onTick(PCB *pcb, long used) {
+	charge(pcb, used);
+	insert(pcb);
+}
+
+static void onPreempt(PCB *pcb, long used) {
+	charge(pcb, used);
+	insert(pcb);
+}
+
+static void onBlock(PCB *pcb, long used) {
+	charge(pcb, used);
+}
+
+static void onUnblock(PCB *pcb) {
+	Entity *entity = &entities[pcb->localPID];
+	if (entity->vruntime < queues[pcb->processor].minVruntime) entity->vruntime = queues[pcb->processor].minVruntime;
+	insert(pcb);
+}
+
+static void onExit(PCB *pcb, long used) {}
+
+SchedulerOps cfsScheduler = {
+	.name = "cfs",
+	.initialize = initialize,
+	.enqueue = enqueue,
+	.dequeue = dequeue,
+	.pick_next = pickNext,
+	.steal = steal,
+	.load = load,
+	.depth = depth,
+	.quantum = quantum,
+	.on_tick = onTick,
+	.on_preempt = onPreempt,
+	.on_block = onBlock,
+	.on_unblock = onUnblock,
+	.on_exit = onExit
+};
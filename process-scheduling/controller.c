@@ -0,0 +1,65 @@
+/*
+ * controller.c 11/9/20
+ * Jared Diehl (jmddnb@umsystem.edu)
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "controller.h"
+
+/*
+ * Latency comes first. Quanta shrink while new processes wait longer than the target for their first turn, grow
+ * while CPUs switch more often than wanted, and otherwise grow slowly back toward throughput only once response
+ * times are well under the target, so they settle in between instead of swinging every window.
+ */
+
+/* Takes the response time target in milliseconds, optionally followed by the most switches per second and bounds on the scale */
+bool controller_init(Controller *controller, char *spec) {
+	double target, switches = CONTROLLER_SWITCHES, min = CONTROLLER_SCALE_MIN, max = CONTROLLER_SCALE_MAX;
+	int n = sscanf(spec, "%lf:%lf:%lf:%lf", &target, &switches, &min, &max);
+	if (n < 1 || n == 3 || target <= 0 || switches <= 0 || min <= 0 || min > 1 || max < 1) return false;
+	
+	memset(controller, 0, sizeof(Controller));
+	controller->target = target * 1e6;
+	controller->switches = switches;
+	controller->min = min;
+	controller->max = max;
+	controller->scale = 1;
+	return true;
+}
+
+/* Counts a dispatch, along with the response time of a process dispatched for the first time */
+void controller_dispatch(Controller *controller, bool first, long response) {
+	controller->dispatches++;
+	if (!first) return;
+	controller->responses += response;
+	controller->responded++;
+}
+
+/* Ends the window, returning whether the scale changed */
+bool controller_update(Controller *controller, long now, unsigned int cpus) {
+	long window = now - controller->start;
+	if (window <= 0) return false;
+	
+	double rate = controller->dispatches / (window / 1e9) / cpus;
+	long response = controller->responded > 0 ? controller->responses / controller->responded : 0;
+	double scale = controller->scale;
+	
+	if (response > controller->target) scale *= CONTROLLER_SHRINK;
+	else if (rate > controller->switches) scale *= CONTROLLER_GROW;
+	else if (controller->responded > 0 && response < controller->target / 2) scale *= CONTROLLER_GROW;
+	
+	if (scale < controller->min) scale = controller->min;
+	if (scale > controller->max) scale = controller->max;
+	
+	controller->start = now;
+	controller->responses = 0;
+	controller->responded = 0;
+	controller->dispatches = 0;
+	
+	if (scale == controller->scale) return false;
+	controller->scale = scale;
+	controller->adjustments++;
+	return true;
+}
@@ -0,0 +1,35 @@
+/*
+ * controller.h 11/9/20
+ * Jared Diehl (jmddnb@umsystem.edu)
+ */
+
+#ifndef CONTROLLER_H
+#define CONTROLLER_H
+
+#include <stdbool.h>
+
+#define CONTROLLER_INTERVAL 100000000 /* Nanoseconds of simulated time between adjustments */
+#define CONTROLLER_SWITCHES 200 /* Default most dispatches per second on each CPU */
+#define CONTROLLER_SCALE_MIN 0.125 /* Default bounds on the scale */
+#define CONTROLLER_SCALE_MAX 8
+#define CONTROLLER_SHRINK 0.8
+#define CONTROLLER_GROW 1.25
+
+/* Feedback controller that scales quanta to meet a response time target without switching too often */
+typedef struct {
+	long target; /* Mean response time wanted, in nanoseconds */
+	double switches; /* Most dispatches per second on each CPU wanted */
+	double min, max; /* Bounds on the scale */
+	double scale; /* Of every normal queue's default quantum */
+	long start; /* Start of the current window */
+	long responses; /* Summed over processes first dispatched in the window */
+	unsigned int responded;
+	unsigned int dispatches;
+	unsigned int adjustments;
+} Controller;
+
+bool controller_init(Controller*, char*);
+void controller_dispatch(Controller*, bool, long);
+bool controller_update(Controller*, long, unsigned int);
+
+#endif
@@ -0,0 +1,31 @@
+/*
+ * decision.c 11/9/20
+ * Jared Diehl (jmddnb@umsystem.edu)
+ */
+
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "decision.h"
+#include "shared.h"
+#include "user.h"
+
+bool shouldTerminate(PCB *pcb) {
+	return rand() % 100 < (CHANCE_PROCESS_TERMINATES * (pcb->priority == 0 ? 2 : 1));
+}
+
+bool shouldExpire(PCB *pcb) {
+	return rand() % 100 < CHANCE_PROCESS_EXPIRES;
+}
+
+/* Returns a random percentage from 1 to 99 */
+int getUsedPercent() {
+	return (rand() % 99) + 1;
+}
+
+/* Returns a random amount of time to stay blocked, up to 3 seconds */
+long getBlockedDuration() {
+	int addsec = rand() % (3 + 1);
+	int addns = rand() % (1000 + 1);
+	return addsec * 1e9 + addns;
+}
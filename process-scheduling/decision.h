@@ -0,0 +1,18 @@
+/*
+ * decision.h 11/9/20
+ * Jared Diehl (jmddnb@umsystem.edu)
+ */
+
+#ifndef DECISION_H
+#define DECISION_H
+
+#include <stdbool.h>
+
+#include "shared.h"
+
+bool shouldTerminate(PCB*);
+bool shouldExpire(PCB*);
+int getUsedPercent();
+long getBlockedDuration();
+
+#endif
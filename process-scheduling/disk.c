@@ -0,0 +1,129 @@
+/*
+ * disk.c 11/9/20
+ * Jared Diehl (jmddnb@umsystem.edu)
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "disk.h"
+
+static char *names[DISK_POLICY_COUNT] = { "fcfs", "sstf", "scan", "clook" };
+
+static bool below(RBNode *a, RBNode *b) {
+	return ((DiskRequest*) a)->cylinder < ((DiskRequest*) b)->cylinder;
+}
+
+/* Finds the nearest pending requests on either side of the arm, where one at the arm's cylinder counts as above it */
+static void around(Disk *disk, DiskRequest **lower, DiskRequest **upper) {
+	RBNode *node = disk->pending.root;
+	*lower = *upper = NULL;
+	while (node != NULL) {
+		DiskRequest *request = (DiskRequest*) node;
+		if (request->cylinder >= disk->head) {
+			*upper = request;
+			node = node->left;
+		} else {
+			*lower = request;
+			node = node->right;
+		}
+	}
+}
+
+static unsigned int distance(unsigned int a, unsigned int b) {
+	return a > b ? a - b : b - a;
+}
+
+/* Takes the next request off the queue by the disk's policy, setting how far the arm has to move for it */
+static DiskRequest *pick(Disk *disk, unsigned int *moved) {
+	if (disk->policy == DISK_FCFS) {
+		DiskRequest *request = disk->first;
+		disk->first = request->next;
+		if (disk->first == NULL) disk->last = NULL;
+		*moved = distance(disk->head, request->cylinder);
+		return request;
+	}
+	
+	DiskRequest *lower, *upper, *request;
+	around(disk, &lower, &upper);
+	
+	if (disk->policy == DISK_SSTF) {
+		if (upper == NULL || (lower != NULL && disk->head - lower->cylinder < upper->cylinder - disk->head)) request = lower;
+		else request = upper;
+		*moved = distance(disk->head, request->cylinder);
+	} else if (disk->policy == DISK_SCAN) {
+		/* Runs to the edge before turning around if nothing is left ahead of the arm */
+		if (disk->up && upper == NULL) {
+			disk->up = false;
+			*moved = (DISK_CYLINDERS - 1 - disk->head) + (DISK_CYLINDERS - 1 - lower->cylinder);
+			request = lower;
+		} else if (!disk->up && lower == NULL && (upper == NULL || upper->cylinder != disk->head)) {
+			disk->up = true;
+			*moved = disk->head + upper->cylinder;
+			request = upper;
+		} else {
+			request = disk->up || (upper != NULL && upper->cylinder == disk->head) ? upper : lower;
+			*moved = distance(disk->head, request->cylinder);
+		}
+	} else {
+		/* Only serves on the way up, jumping back to the lowest request once there's nothing above */
+		request = upper != NULL ? upper : (DiskRequest*) rbtree_first(&disk->pending);
+		*moved = distance(disk->head, request->cylinder);
+	}
+	
+	rbtree_erase(&disk->pending, &request->node);
+	return request;
+}
+
+/* Returns the policy named, or -1 if there's none */
+int disk_policy(char *name) {
+	int i;
+	for (i = 0; i < DISK_POLICY_COUNT; i++)
+		if (strcmp(name, names[i]) == 0) return i;
+	return -1;
+}
+
+char *disk_policy_name(int policy) {
+	return names[policy];
+}
+
+void disk_initialize(Disk *disk, int policy) {
+	memset(disk, 0, sizeof(Disk));
+	disk->policy = policy;
+	disk->up = true;
+	rbtree_initialize(&disk->pending, below);
+}
+
+void disk_submit(Disk *disk, DiskRequest *request) {
+	request->next = NULL;
+	if (disk->policy == DISK_FCFS) {
+		if (disk->last == NULL) disk->first = request;
+		else disk->last->next = request;
+		disk->last = request;
+	} else rbtree_insert(&disk->pending, &request->node);
+	disk->queued++;
+}
+
+/* Starts serving the next request if the disk is idle and has one, setting how long it will take */
+DiskRequest *disk_start(Disk *disk, long *service) {
+	if (disk->active != NULL || disk->queued == 0) return NULL;
+	
+	unsigned int moved;
+	DiskRequest *request = pick(disk, &moved);
+	disk->queued--;
+	
+	*service = DISK_TRANSFER + (long) ((double) rand() / RAND_MAX * DISK_ROTATION);
+	if (moved > 0) *service += DISK_SETTLE + (long) (DISK_STROKE * sqrt((double) moved / DISK_CYLINDERS));
+	
+	disk->head = request->cylinder;
+	disk->distance += moved;
+	disk->busy += *service;
+	disk->active = request;
+	return request;
+}
+
+void disk_finish(Disk *disk) {
+	disk->active = NULL;
+	disk->served++;
+}
@@ -0,0 +1,54 @@
+/*
+ * disk.h 11/9/20
+ * Jared Diehl (jmddnb@umsystem.edu)
+ */
+
+#ifndef DISK_H
+#define DISK_H
+
+#include <stdbool.h>
+
+#include "rbtree.h"
+
+#define DISKS_MAX 16
+#define DISK_CYLINDERS 10000
+
+/* Service time model in nanoseconds, roughly a 7200 RPM drive */
+#define DISK_SETTLE 1000000 /* Any seek at all */
+#define DISK_STROKE 9000000 /* Added for a seek across every cylinder, scaled by the square root of the distance */
+#define DISK_ROTATION 8333333 /* One revolution, of which a request waits a random part */
+#define DISK_TRANSFER 200000
+
+enum DiskPolicy { DISK_FCFS, DISK_SSTF, DISK_SCAN, DISK_CLOOK, DISK_POLICY_COUNT };
+
+typedef struct DiskRequest {
+	RBNode node; /* In the pending tree by cylinder, for every policy but FCFS */
+	struct DiskRequest *next; /* In arrival order, for FCFS */
+	unsigned int cylinder;
+	unsigned int localPID;
+	unsigned int disk;
+	long submit; /* Simulated time it was queued in nanoseconds */
+} DiskRequest;
+
+/* One arm over DISK_CYLINDERS cylinders, serving one request at a time */
+typedef struct {
+	int policy;
+	unsigned int head; /* Cylinder the arm is over */
+	bool up; /* Direction the arm is sweeping, for SCAN */
+	DiskRequest *first, *last;
+	RBTree pending;
+	unsigned int queued;
+	DiskRequest *active; /* Being served, or NULL if idle */
+	unsigned long served;
+	unsigned long distance; /* Cylinders the arm has moved */
+	long busy; /* Nanoseconds spent serving */
+} Disk;
+
+int disk_policy(char*);
+char *disk_policy_name(int);
+void disk_initialize(Disk*, int);
+void disk_submit(Disk*, DiskRequest*);
+DiskRequest *disk_start(Disk*, long*);
+void disk_finish(Disk*);
+
+#endif
@@ -0,0 +1,145 @@
+/*
+ * edf.c 11/9/20
+ * Jared Diehl (jmddnb@umsystem.edu)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "calendar.h"
+#include "scheduler.h"
+
+/* Range a real-time period is picked from, which is also its relative deadline */
+#define EDF_PERIOD_MIN (QUANTUM_BASE * 2)
+#define EDF_PERIOD_MAX (QUANTUM_BASE * 10)
+/* EDF meets every deadline on one CPU as long as total utilization doesn't go past this */
+#define EDF_UTILIZATION_BOUND 1.0
+
+/*
+ * Earliest-deadline-first class for real-time processes, which always runs ahead of the scheduling policy. Each
+ * process gets one quantum of budget per period. Using up the budget, or blocking, finishes the current job and
+ * pushes its deadline out a period, so a process that runs early can't crowd out the others. This is global EDF:
+ * every CPU picks from one queue ordered by deadline, so the earliest deadlines run on whichever CPUs come free. A
+ * process is only admitted while total utilization stays within m - (m - 1) times the largest utilization of any
+ * process, for m CPUs, which is the bound global EDF meets every deadline under.
+ */
+
+static Calendar *deadlines; /* Runnable real-time processes ordered by deadline */
+static double utilization; /* Sum of budget over period for every admitted process */
+static double peak; /* Largest utilization of any process admitted so far */
+static unsigned int cpus;
+static unsigned int misses;
+
+static double getUtilization(PCB *pcb) {
+	return (double) getUserQuantum(pcb->priority) / (double) pcb->period;
+}
+
+static void push(PCB *pcb) {
+	calendar_push(deadlines, 0, &pcb->deadline, pcb->localPID);
+}
+
+/* Counts a miss if the job that just ended finished after its deadline */
+static void finishJob(PCB *pcb) {
+	if (compareTime(&getSharedMemory()->system, &pcb->deadline) > 0) misses++;
+	addTime(&pcb->deadline, pcb->period);
+}
+
+static void initialize(unsigned int count, unsigned int concurrency) {
+	deadlines = calendar_create(concurrency);
+	cpus = count;
+	utilization = 0;
+	peak = 0;
+	misses = 0;
+}
+
+/*
+ * Utilization-bound test, so a process whose deadlines can't all be met is turned away up front. Global EDF on
+ * more than one CPU loses capacity to heavy processes, so the bound shrinks with the heaviest one (Goossens et al.).
+ */
+static bool admit(PCB *pcb) {
+	pcb->period = EDF_PERIOD_MIN + rand() % (long) (EDF_PERIOD_MAX - EDF_PERIOD_MIN + 1);
+	double u = getUtilization(pcb);
+	double heaviest = u > peak ? u : peak;
+	if (utilization + u > EDF_UTILIZATION_BOUND * (cpus - (cpus - 1) * heaviest)) return false;
+	utilization += u;
+	peak = heaviest;
+	return true;
+}
+
+static void enqueue(PCB *pcb) {
+	copyTime(&getSharedMemory()->system, &pcb->deadline);
+	addTime(&pcb->deadline, pcb->period);
+	push(pcb);
+}
+
+static void dequeue(PCB *pcb) {
+	calendar_remove(deadlines, pcb->localPID);
+}
+
+static PCB *pickNext(unsigned int cpu) {
+	Event event;
+	if (!calendar_pop(deadlines, &event)) return NULL;
+	return &getSharedMemory()->ptable[event.localPID];
+}
+
+static unsigned int depth(unsigned int priority) {
+	return priority == 0 ? deadlines->size : 0;
+}
+
+static int quantum(PCB *pcb) {
+	return getUserQuantum(pcb->priority);
+}
+
+static bool preempts(PCB *pcb, PCB *running) {
+	return compareTime(&pcb->deadline, &running->deadline) < 0;
+}
+
+static void onTick(PCB *pcb, long used) {
+	finishJob(pcb);
+	push(pcb);
+}
+
+/* The job isn't finished, so its deadline stays where it is */
+static void onPreempt(PCB *pcb, long used) {
+	push(pcb);
+}
+
+static void onBlock(PCB *pcb, long used) {
+	finishJob(pcb);
+}
+
+/* A process that slept past its deadline starts a fresh job instead of jumping ahead of everyone */
+static void onUnblock(PCB *pcb) {
+	Time *system = &getSharedMemory()->system;
+	if (compareTime(&pcb->deadline, system) < 0) {
+		copyTime(system, &pcb->deadline);
+		addTime(&pcb->deadline, pcb->period);
+	}
+	push(pcb);
+}
+
+static void onExit(PCB *pcb, long used) {
+	if (compareTime(&getSharedMemory()->system, &pcb->deadline) > 0) misses++;
+	utilization -= getUtilization(pcb);
+}
+
+unsigned int getDeadlineMisses() {
+	return misses;
+}
+
+SchedulerOps edfScheduler = {
+	.name = "edf",
+	.initialize = initialize,
+	.admit = admit,
+	.enqueue = enqueue,
+	.dequeue = dequeue,
+	.pick_next = pickNext,
+	.depth = depth,
+	.quantum = quantum,
+	.preempts = preempts,
+	.on_tick = onTick,
+	.on_preempt = onPreempt,
+	.on_block = onBlock,
+	.on_unblock = onUnblock,
+	.on_exit = onExit
+};
@@ -0,0 +1,72 @@
+/*
+ * fiber.c 11/9/20
+ * Jared Diehl (jmddnb@umsystem.edu)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <ucontext.h>
+
+#include "fiber.h"
+#include "shared.h"
+
+static Fiber *current = NULL; /* Fiber that is running */
+static Fiber *released = NULL; /* Fibers whose stacks can be reused */
+
+static void start() {
+	Fiber *fiber = current;
+	fiber->function(fiber->argument);
+	fiber->finished = true;
+	/* Returning switches back to the caller through uc_link */
+}
+
+Fiber *fiber_create(void (*function)(void*), void *argument) {
+	Fiber *fiber;
+	
+	/* Reuse a released fiber's stack before allocating a new one */
+	if (released != NULL) {
+		fiber = released;
+		released = fiber->next;
+	} else {
+		fiber = (Fiber*) malloc(sizeof(Fiber));
+		fiber->stack = (char*) malloc(FIBER_STACK_SIZE);
+		if (fiber->stack == NULL) crash("malloc");
+	}
+	
+	fiber->function = function;
+	fiber->argument = argument;
+	fiber->finished = false;
+	fiber->next = NULL;
+	
+	if (getcontext(&fiber->context) == -1) crash("getcontext");
+	fiber->context.uc_stack.ss_sp = fiber->stack;
+	fiber->context.uc_stack.ss_size = FIBER_STACK_SIZE;
+	fiber->context.uc_link = &fiber->caller;
+	makecontext(&fiber->context, start, 0);
+	
+	return fiber;
+}
+
+/* Runs a fiber until it yields or finishes */
+void fiber_resume(Fiber *fiber) {
+	if (fiber->finished) return;
+	Fiber *previous = current;
+	current = fiber;
+	if (swapcontext(&fiber->caller, &fiber->context) == -1) crash("swapcontext");
+	current = previous;
+}
+
+/* Switches from the running fiber back to whoever resumed it */
+void fiber_yield() {
+	Fiber *fiber = current;
+	if (swapcontext(&fiber->context, &fiber->caller) == -1) crash("swapcontext");
+}
+
+bool fiber_finished(Fiber *fiber) {
+	return fiber->finished;
+}
+
+void fiber_release(Fiber *fiber) {
+	fiber->next = released;
+	released = fiber;
+}
@@ -0,0 +1,30 @@
+/*
+ * fiber.h 11/9/20
+ * Jared Diehl (jmddnb@umsystem.edu)
+ */
+
+#ifndef FIBER_H
+#define FIBER_H
+
+#include <stdbool.h>
+#include <ucontext.h>
+
+#define FIBER_STACK_SIZE (16 * 1024)
+
+typedef struct Fiber {
+	ucontext_t context;
+	ucontext_t caller;
+	char *stack;
+	void (*function)(void*);
+	void *argument;
+	bool finished;
+	struct Fiber *next; /* Next released fiber */
+} Fiber;
+
+Fiber *fiber_create(void (*)(void*), void*);
+void fiber_resume(Fiber*);
+void fiber_yield();
+bool fiber_finished(Fiber*);
+void fiber_release(Fiber*);
+
+#endif
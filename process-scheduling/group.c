@@ -0,0 +1,328 @@
+/*
+ * group.c 11/9/20
+ * Jared Diehl (jmddnb@umsystem.edu)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rbtree.h"
+#include "scheduler.h"
+
+#define GROUP_WEIGHT_UNIT 1024
+
+/*
+ * Two-level CPU-share groups. Each group has a weight, and optionally a quota of CPU time per GROUP_PERIOD. Every CPU
+ * keeps its groups with queued processes in a red-black tree ordered by the group's virtual runtime, which is the CPU
+ * time its processes had there scaled down by its weight, and runs the group that has had the least of it. Within a
+ * group, processes take turns round-robin.
+ *
+ * A group's quota is shared by every CPU. A slice is taken out of it when a process is picked and whatever the process
+ * didn't use is given back after, so CPUs running the same group at once can't overrun it between them. A group that
+ * has used up its quota is passed over until the next period.
+ */
+
+typedef struct {
+	RBNode node;
+	long vruntime;
+	int head, tail; /* Queued processes by local PID, or -1 */
+	unsigned int queued;
+} GroupQueue;
+
+typedef struct {
+	unsigned int group;
+	int next, prev; /* Within its group's queue on its CPU */
+	long slice; /* Taken out of the group's quota when it was picked */
+	long period; /* Period the slice was taken in */
+} Member;
+
+typedef struct {
+	long minVruntime;
+	RBTree tree;
+} Cpu;
+
+static GroupStats groups[GROUPS_MAX];
+static unsigned int groupCount = 0;
+static long inverses[GROUPS_MAX]; /* GROUP_WEIGHT_UNIT over the weight, in 1/1024ths, so charging only shifts */
+static long used[GROUPS_MAX]; /* Quota used in the current period, including slices handed out */
+static long periods[GROUPS_MAX]; /* Period used[] is for */
+static long exhausted[GROUPS_MAX]; /* Period the group last ran out of quota in */
+static unsigned int waiting[GROUPS_MAX]; /* Processes queued across every CPU */
+
+static Cpu *cpus;
+static GroupQueue *queues; /* Indexed by CPU, then group */
+static Member *members; /* Indexed by local PID */
+static unsigned int queuedByPriority[QUEUE_SET_COUNT];
+static unsigned int assigned = 0; /* Processes given a group so far, which spreads them round-robin */
+
+static long getNow() {
+	return getNanoseconds(&getSharedMemory()->system);
+}
+
+static PCB *getPCB(unsigned int localPID) {
+	return &getSharedMemory()->ptable[localPID];
+}
+
+static GroupQueue *getQueue(unsigned int cpu, unsigned int group) {
+	return &queues[cpu * groupCount + group];
+}
+
+static bool less(RBNode *a, RBNode *b) {
+	return ((GroupQueue*) a)->vruntime < ((GroupQueue*) b)->vruntime;
+}
+
+/* Starts the group on a new period if the clock has moved into one */
+static void refresh(unsigned int group, long now) {
+	long period = now / GROUP_PERIOD;
+	if (periods[group] != period) {
+		periods[group] = period;
+		used[group] = 0;
+	}
+}
+
+static bool throttled(unsigned int group, long now) {
+	if (groups[group].quota == 0) return false;
+	refresh(group, now);
+	if (used[group] < groups[group].quota) return false;
+	
+	if (exhausted[group] != periods[group]) {
+		exhausted[group] = periods[group];
+		groups[group].throttles++;
+	}
+	return true;
+}
+
+static void insert(PCB *pcb) {
+	Member *member = &members[pcb->localPID];
+	Cpu *cpu = &cpus[pcb->processor];
+	GroupQueue *queue = getQueue(pcb->processor, member->group);
+	
+	member->next = -1;
+	member->prev = queue->tail;
+	if (queue->tail == -1) queue->head = pcb->localPID;
+	else members[queue->tail].next = pcb->localPID;
+	queue->tail = pcb->localPID;
+	
+	/* A group that had nothing queued here starts level with the least-run one, so it can't bank idle time */
+	if (queue->queued++ == 0) {
+		if (queue->vruntime < cpu->minVruntime) queue->vruntime = cpu->minVruntime;
+		rbtree_insert(&cpu->tree, &queue->node);
+	}
+	
+	waiting[member->group]++;
+	queuedByPriority[pcb->priority]++;
+}
+
+static void unlink(PCB *pcb, unsigned int cpu) {
+	Member *member = &members[pcb->localPID];
+	GroupQueue *queue = getQueue(cpu, member->group);
+	
+	if (member->prev == -1) queue->head = member->next;
+	else members[member->prev].next = member->next;
+	if (member->next == -1) queue->tail = member->prev;
+	else members[member->next].prev = member->prev;
+	
+	if (--queue->queued == 0) rbtree_erase(&cpus[cpu].tree, &queue->node);
+	
+	waiting[member->group]--;
+	queuedByPriority[pcb->priority]--;
+}
+
+/* First group queued on the CPU that still has quota, or NULL if every one is throttled */
+static GroupQueue *pickGroup(unsigned int cpu, long now) {
+	RBNode *node;
+	for (node = rbtree_first(&cpus[cpu].tree); node != NULL; node = rbtree_next(node)) {
+		GroupQueue *queue = (GroupQueue*) node;
+		if (!throttled((queue - queues) % groupCount, now)) return queue;
+	}
+	return NULL;
+}
+
+/* Takes the slice the process will run for out of its group's quota, where a preempted process only needs what it has left */
+static PCB *take(PCB *pcb, unsigned int cpu, long now) {
+	unsigned int group = members[pcb->localPID].group;
+	unlink(pcb, cpu);
+	
+	long slice = pcb->remaining > 0 ? pcb->remaining : getUserQuantum(pcb->priority);
+	if (groups[group].quota > 0) {
+		refresh(group, now);
+		if (pcb->remaining == 0 && slice > groups[group].quota - used[group]) slice = groups[group].quota - used[group];
+		used[group] += slice;
+	}
+	
+	GroupQueue *queue = getQueue(cpu, group);
+	if (queue->vruntime > cpus[cpu].minVruntime) cpus[cpu].minVruntime = queue->vruntime;
+	
+	members[pcb->localPID].slice = slice;
+	members[pcb->localPID].period = periods[group];
+	return pcb;
+}
+
+/* Charges the group for what the process ran, giving back the rest of its slice, where only constant work is done */
+static void charge(PCB *pcb, long ran) {
+	Member *member = &members[pcb->localPID];
+	unsigned int group = member->group;
+	GroupQueue *queue = getQueue(pcb->processor, group);
+	
+	/* The group's position on the CPU can only change if it's in the tree, which costs a reinsertion */
+	bool queued = queue->queued > 0;
+	if (queued) rbtree_erase(&cpus[pcb->processor].tree, &queue->node);
+	queue->vruntime += ran * inverses[group] / GROUP_WEIGHT_UNIT;
+	if (queued) rbtree_insert(&cpus[pcb->processor].tree, &queue->node);
+	
+	groups[group].cpu += ran;
+	if (groups[group].quota == 0) return;
+	
+	/* A slice that ran into the next period only counts the part run in it */
+	long now = getNow();
+	refresh(group, now);
+	if (member->period == periods[group]) used[group] += ran - member->slice;
+	else used[group] += ran < now % GROUP_PERIOD ? ran : now % GROUP_PERIOD;
+}
+
+static void initialize(unsigned int count, unsigned int concurrency) {
+	/* One group of every process, unless they were set up before */
+	if (groupCount == 0) setGroups("1");
+	
+	cpus = (Cpu*) calloc(count, sizeof(Cpu));
+	queues = (GroupQueue*) calloc(count * groupCount, sizeof(GroupQueue));
+	members = (Member*) calloc(concurrency + 1, sizeof(Member));
+	
+	unsigned int i;
+	for (i = 0; i < count; i++) rbtree_initialize(&cpus[i].tree, less);
+	for (i = 0; i < count * groupCount; i++) queues[i].head = queues[i].tail = -1;
+	for (i = 0; i < groupCount; i++) periods[i] = exhausted[i] = -1;
+}
+
+static void enqueue(PCB *pcb) {
+	unsigned int group = assigned++ % groupCount;
+	members[pcb->localPID].group = group;
+	groups[group].processes++;
+	insert(pcb);
+}
+
+static void dequeue(PCB *pcb) {
+	unlink(pcb, pcb->processor);
+}
+
+static PCB *pickNext(unsigned int cpu) {
+	long now = getNow();
+	GroupQueue *queue = pickGroup(cpu, now);
+	if (queue == NULL) return NULL;
+	return take(getPCB(queue->head), cpu, now);
+}
+
+/* Takes the process that would run last of the group that would run next, if it isn't throttled */
+static PCB *steal(unsigned int from, unsigned int to) {
+	long now = getNow();
+	GroupQueue *queue = pickGroup(from, now);
+	if (queue == NULL) return NULL;
+	return take(getPCB(queue->tail), from, now);
+}
+
+/* Only counts processes in groups that still have quota, so a CPU whose groups are all throttled isn't stolen from */
+static unsigned int load(unsigned int cpu) {
+	long now = getNow();
+	unsigned int runnable = 0;
+	RBNode *node;
+	for (node = rbtree_first(&cpus[cpu].tree); node != NULL; node = rbtree_next(node)) {
+		GroupQueue *queue = (GroupQueue*) node;
+		if (!throttled((queue - queues) % groupCount, now)) runnable += queue->queued;
+	}
+	return runnable;
+}
+
+static unsigned int depth(unsigned int priority) {
+	return queuedByPriority[priority];
+}
+
+static int quantum(PCB *pcb) {
+	return members[pcb->localPID].slice;
+}
+
+static void onTick(PCB *pcb, long ran) {
+	charge(pcb, ran);
+	insert(pcb);
+}
+
+static void onPreempt(PCB *pcb, long ran) {
+	charge(pcb, ran);
+	insert(pcb);
+}
+
+static void onBlock(PCB *pcb, long ran) {
+	charge(pcb, ran);
+}
+
+static void onUnblock(PCB *pcb) {
+	insert(pcb);
+}
+
+static void onExit(PCB *pcb, long ran) {
+	charge(pcb, ran);
+	
+	GroupStats *group = &groups[members[pcb->localPID].group];
+	group->exited++;
+	group->turnaround += getNow() - getNanoseconds(&pcb->arrival);
+}
+
+/* Next period start, if a group with processes queued has used up its quota */
+static long refill() {
+	long now = getNow();
+	unsigned int i;
+	for (i = 0; i < groupCount; i++)
+		if (waiting[i] > 0 && throttled(i, now)) return (now / GROUP_PERIOD + 1) * GROUP_PERIOD;
+	return -1;
+}
+
+/* Takes a comma-separated weight for every group, each optionally followed by a quota in percent of a CPU per period */
+bool setGroups(char *spec) {
+	char buf[BUFFER_LENGTH];
+	strncpy(buf, spec, BUFFER_LENGTH - 1);
+	buf[BUFFER_LENGTH - 1] = '\0';
+	
+	unsigned int count = 0;
+	char *token, *save;
+	for (token = strtok_r(buf, ",", &save); token != NULL; token = strtok_r(NULL, ",", &save)) {
+		int weight, quota = 0;
+		int n = sscanf(token, "%d:%d", &weight, &quota);
+		if (count == GROUPS_MAX || n < 1 || weight < 1 || weight > GROUP_WEIGHT_UNIT || quota < 0) return false;
+		
+		memset(&groups[count], 0, sizeof(GroupStats));
+		groups[count].weight = weight;
+		groups[count].quota = (long) quota * GROUP_PERIOD / 100;
+		inverses[count] = GROUP_WEIGHT_UNIT * GROUP_WEIGHT_UNIT / weight;
+		count++;
+	}
+	if (count == 0) return false;
+	
+	groupCount = count;
+	return true;
+}
+
+unsigned int getGroupCount() {
+	return groupCount;
+}
+
+GroupStats *getGroupStats(unsigned int group) {
+	return &groups[group];
+}
+
+SchedulerOps groupScheduler = {
+	.name = "group",
+	.initialize = initialize,
+	.enqueue = enqueue,
+	.dequeue = dequeue,
+	.pick_next = pickNext,
+	.steal = steal,
+	.load = load,
+	.depth = depth,
+	.quantum = quantum,
+	.on_tick = onTick,
+	.on_preempt = onPreempt,
+	.on_block = onBlock,
+	.on_unblock = onUnblock,
+	.on_exit = onExit,
+	.refill = refill
+};
@@ -0,0 +1,53 @@
+/*
+ * histogram.c 11/9/20
+ * Jared Diehl (jmddnb@umsystem.edu)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "histogram.h"
+
+/* Values below twice the sub-bucket count get a bucket each, then every power of two is split evenly */
+static unsigned int getBucket(unsigned long value) {
+	if (value < 2 * HISTOGRAM_SUB_COUNT) return value;
+	unsigned int exponent = 63 - __builtin_clzl(value);
+	unsigned int shift = exponent - HISTOGRAM_SUB_BITS;
+	return (shift + 1) * HISTOGRAM_SUB_COUNT + (value >> shift) - HISTOGRAM_SUB_COUNT;
+}
+
+/* Smallest value that lands in the bucket */
+static unsigned long getLowest(unsigned int bucket) {
+	if (bucket < 2 * HISTOGRAM_SUB_COUNT) return bucket;
+	unsigned int shift = bucket / HISTOGRAM_SUB_COUNT - 1;
+	return (unsigned long) (bucket % HISTOGRAM_SUB_COUNT + HISTOGRAM_SUB_COUNT) << shift;
+}
+
+Histogram *histogram_create() {
+	return (Histogram*) calloc(1, sizeof(Histogram));
+}
+
+void histogram_record(Histogram *histogram, long value) {
+	if (value < 0) value = 0;
+	histogram->counts[getBucket(value)]++;
+	histogram->total++;
+	if (value > histogram->max) histogram->max = value;
+}
+
+/* Returns the largest value in the bucket holding the percentile, never past the largest value recorded */
+long histogram_percentile(Histogram *histogram, double percentile) {
+	if (histogram->total == 0) return 0;
+	
+	unsigned long rank = (unsigned long) (percentile / 100 * histogram->total + 0.5);
+	if (rank < 1) rank = 1;
+	
+	unsigned long seen = 0;
+	unsigned int i;
+	for (i = 0; i < HISTOGRAM_BUCKETS - 1; i++) {
+		seen += histogram->counts[i];
+		if (seen >= rank) break;
+	}
+	
+	long highest = i < HISTOGRAM_BUCKETS - 1 ? (long) getLowest(i + 1) - 1 : histogram->max;
+	return highest < histogram->max ? highest : histogram->max;
+}
@@ -0,0 +1,25 @@
+/*
+ * histogram.h 11/9/20
+ * Jared Diehl (jmddnb@umsystem.edu)
+ */
+
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+/* 2^5 linear buckets per power of two keeps every recorded value within about 3% */
+#define HISTOGRAM_SUB_BITS 5
+#define HISTOGRAM_SUB_COUNT (1 << HISTOGRAM_SUB_BITS)
+#define HISTOGRAM_BUCKETS ((64 - HISTOGRAM_SUB_BITS + 1) * HISTOGRAM_SUB_COUNT)
+
+/* Log-linear histogram of non-negative values, such as nanoseconds */
+typedef struct {
+	unsigned long counts[HISTOGRAM_BUCKETS];
+	unsigned long total;
+	long max;
+} Histogram;
+
+Histogram *histogram_create();
+void histogram_record(Histogram*, long);
+long histogram_percentile(Histogram*, double);
+
+#endif
@@ -0,0 +1,96 @@
+/*
+ * intake.c 11/9/20
+ * Jared Diehl (jmddnb@umsystem.edu)
+ */
+
+#include <sched.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "intake.h"
+#include "shared.h"
+
+/* Times the consumer polls an empty queue before going to sleep */
+#define INTAKE_SPINS 100
+
+static void push(IntakeQueue *queue, Intake *intake) {
+	unsigned int head = queue->head;
+	
+	/* Only full if the consumer has fallen far behind, so give it a chance to catch up */
+	while (head - __atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE) == INTAKE_SIZE) sched_yield();
+	
+	queue->records[head % INTAKE_SIZE] = *intake;
+	
+	/* Publish the record, then only pay for a wake-up if the consumer is asleep */
+	__atomic_store_n(&queue->head, head + 1, __ATOMIC_SEQ_CST);
+	if (__atomic_load_n(&queue->waiting, __ATOMIC_SEQ_CST)) wakeFutex(&queue->head);
+}
+
+/*
+ * Takes every message off the parent queue as it comes in. A decision other than an expiry is followed by the percent
+ * used, which the process sends right after, so that one is waited for from the same process.
+ */
+static void *run(void *argument) {
+	IntakeQueue *queue = (IntakeQueue*) argument;
+	Message message;
+	
+	while (true) {
+		if (receiveMessage(&message, queue->msqid, 0, true) == -1) break;
+		
+		Intake intake = { .pid = message.type, .percent = 100 };
+		if (strcmp(message.text, "TERMINATED") == 0) intake.decision = DECISION_TERMINATED;
+		else if (strcmp(message.text, "EXPIRED") == 0) intake.decision = DECISION_EXPIRED;
+		else if (strcmp(message.text, "BLOCKED") == 0) intake.decision = DECISION_BLOCKED;
+		
+		if (intake.decision != DECISION_EXPIRED) {
+			if (receiveMessage(&message, queue->msqid, intake.pid, true) == -1) break;
+			intake.percent = atoi(message.text);
+		}
+		
+		push(queue, &intake);
+	}
+	
+	return NULL;
+}
+
+/* Starts the thread with every signal blocked, so the timeout and interrupts still go to the thread simulating */
+IntakeQueue *intake_start(int msqid) {
+	IntakeQueue *queue = (IntakeQueue*) calloc(1, sizeof(IntakeQueue));
+	queue->msqid = msqid;
+	
+	sigset_t all, previous;
+	sigfillset(&all);
+	pthread_sigmask(SIG_SETMASK, &all, &previous);
+	if (pthread_create(&queue->thread, NULL, run, queue) != 0) crash("pthread_create");
+	pthread_sigmask(SIG_SETMASK, &previous, NULL);
+	
+	return queue;
+}
+
+/* Takes the next decision, waiting for one if asked to, and returns whether there was one */
+bool intake_receive(IntakeQueue *queue, Intake *intake, bool wait) {
+	unsigned int tail = queue->tail;
+	int spins = 0;
+	
+	while (__atomic_load_n(&queue->head, __ATOMIC_ACQUIRE) == tail) {
+		if (!wait) return false;
+		if (++spins < INTAKE_SPINS) continue;
+		
+		/* Announce we're sleeping before checking one last time, so a push can't slip by unnoticed */
+		__atomic_store_n(&queue->waiting, 1, __ATOMIC_SEQ_CST);
+		if (__atomic_load_n(&queue->head, __ATOMIC_SEQ_CST) == tail) waitFutex(&queue->head, tail);
+		__atomic_store_n(&queue->waiting, 0, __ATOMIC_RELAXED);
+	}
+	
+	*intake = queue->records[tail % INTAKE_SIZE];
+	__atomic_store_n(&queue->tail, tail + 1, __ATOMIC_RELEASE);
+	return true;
+}
+
+/* The thread is only ever waiting on the message queue, which it can be cancelled out of */
+void intake_stop(IntakeQueue *queue) {
+	pthread_cancel(queue->thread);
+	pthread_join(queue->thread, NULL);
+	free(queue);
+}
@@ -0,0 +1,37 @@
+/*
+ * intake.h 11/9/20
+ * Jared Diehl (jmddnb@umsystem.edu)
+ */
+
+#ifndef INTAKE_H
+#define INTAKE_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <sys/types.h>
+
+/* Never more decisions in flight than there are CPUs */
+#define INTAKE_SIZE 128
+
+/* Decision of a user process, taken off the message queue whole */
+typedef struct {
+	pid_t pid;
+	int decision;
+	int percent;
+} Intake;
+
+/* Single-producer/single-consumer queue that a thread fills with decisions from the message queue */
+typedef struct {
+	unsigned int head; /* Next slot to write, only written by the intake thread */
+	unsigned int tail; /* Next slot to read, only written by the consumer */
+	unsigned int waiting; /* Set while the consumer sleeps on head */
+	Intake records[INTAKE_SIZE];
+	int msqid;
+	pthread_t thread;
+} IntakeQueue;
+
+IntakeQueue *intake_start(int);
+bool intake_receive(IntakeQueue*, Intake*, bool);
+void intake_stop(IntakeQueue*);
+
+#endif
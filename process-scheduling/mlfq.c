@@ -0,0 +1,191 @@
+/*
+ * mlfq.c 11/9/20
+ * Jared Diehl (jmddnb@umsystem.edu)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "runqueue.h"
+#include "scheduler.h"
+
+/* Every normal process goes back to the top normal queue this often */
+#define MLFQ_BOOST_PERIOD (QUANTUM_BASE * 100)
+/* A process waiting this long per level below the top is moved up one */
+#define MLFQ_AGING_STEP (QUANTUM_BASE * 10)
+
+/*
+ * Multi-level feedback queue. Processes run from the active set, and a normal process that uses its entire
+ * quantum goes to the expired set, one queue lower once it's been at its priority long enough. The sets swap
+ * once the active set runs dry. Real-time processes stay at priority 0 in the active set. Every CPU has its
+ * own pair of sets.
+ *
+ * So nothing starves at the bottom, a process that has waited too long at the head of its queue is moved up one,
+ * and every so often each lower queue is spliced onto the top normal queue whole. Only queue heads are looked at,
+ * so a process moved by a boost only has its priority brought up to date once it's taken off the queue.
+ */
+
+static RunQueue **active; /* Indexed by CPU */
+static RunQueue **expired;
+static long *since; /* Time each process was queued at its current priority, indexed by local PID */
+static long *boosted; /* Time of the last boost, indexed by CPU */
+static unsigned int cpus;
+
+static long getNow() {
+	return getNanoseconds(&getSharedMemory()->system);
+}
+
+static void push(RunQueue *runqueue, PCB *pcb) {
+	since[pcb->localPID] = getNow();
+	runqueue_push(runqueue, pcb->priority, pcb->localPID);
+}
+
+/* Brings a process taken off the queue up to date with the priority it was queued at */
+static PCB *take(unsigned int localPID, unsigned int priority) {
+	PCB *pcb = &getSharedMemory()->ptable[localPID];
+	if (pcb->priority != priority) {
+		pcb->priority = priority;
+		clearTime(&pcb->queue);
+	}
+	return pcb;
+}
+
+static void boost(RunQueue *runqueue) {
+	unsigned int i;
+	for (i = 2; i < QUEUE_SET_COUNT; i++) runqueue_splice(runqueue, i, 1);
+}
+
+/* Moves up every process that has waited too long at the head of its queue, from the top queue down */
+static void age(RunQueue *runqueue, long now) {
+	unsigned int i;
+	for (i = 2; i < QUEUE_SET_COUNT; i++) {
+		int localPID;
+		while ((localPID = runqueue_peek(runqueue, i)) != -1 && now - since[localPID] >= MLFQ_AGING_STEP * (i - 1))
+			push(runqueue, take(runqueue_pop(runqueue, i), i - 1));
+	}
+}
+
+/* Runs before each pick, touching each queue's head at most and never every process */
+static void preventStarvation(unsigned int cpu) {
+	long now = getNow();
+	if (now - boosted[cpu] >= MLFQ_BOOST_PERIOD) {
+		boost(active[cpu]);
+		boost(expired[cpu]);
+		boosted[cpu] = now;
+	} else {
+		age(active[cpu], now);
+		age(expired[cpu], now);
+	}
+}
+
+static void initialize(unsigned int count, unsigned int concurrency) {
+	cpus = count;
+	active = (RunQueue**) malloc(cpus * sizeof(RunQueue*));
+	expired = (RunQueue**) malloc(cpus * sizeof(RunQueue*));
+	since = (long*) calloc(concurrency + 1, sizeof(long));
+	boosted = (long*) calloc(cpus, sizeof(long));
+	
+	unsigned int i;
+	for (i = 0; i < cpus; i++) {
+		active[i] = runqueue_create(QUEUE_SET_COUNT, concurrency);
+		expired[i] = runqueue_create(QUEUE_SET_COUNT, concurrency);
+	}
+}
+
+static void enqueue(PCB *pcb) {
+	push(active[pcb->processor], pcb);
+}
+
+static void dequeue(PCB *pcb) {
+	if (!runqueue_remove(active[pcb->processor], pcb->localPID))
+		runqueue_remove(expired[pcb->processor], pcb->localPID);
+}
+
+static PCB *pickNext(unsigned int cpu) {
+	preventStarvation(cpu);
+	
+	/* Swap the sets once every process in the active set has had its turn */
+	if (runqueue_empty(active[cpu]) && !runqueue_empty(expired[cpu])) {
+		RunQueue *temp = active[cpu];
+		active[cpu] = expired[cpu];
+		expired[cpu] = temp;
+	}
+
+	/* Run a process from the highest priority queue that isn't empty */
+	int priority = runqueue_first(active[cpu]);
+	if (priority == -1) return NULL;
+	return take(runqueue_pop(active[cpu], priority), priority);
+}
+
+/* Takes from the tail of the lowest priority queue, preferring the expired set, since that process would run last */
+static PCB *steal(unsigned int from, unsigned int to) {
+	RunQueue *runqueue = runqueue_empty(expired[from]) ? active[from] : expired[from];
+	int priority = runqueue_last(runqueue);
+	if (priority == -1) return NULL;
+	return take(runqueue_pop_rear(runqueue, priority), priority);
+}
+
+static unsigned int load(unsigned int cpu) {
+	return active[cpu]->size + expired[cpu]->size;
+}
+
+static unsigned int depth(unsigned int priority) {
+	unsigned int i, count = 0;
+	for (i = 0; i < cpus; i++) count += runqueue_count(active[i], priority) + runqueue_count(expired[i], priority);
+	return count;
+}
+
+static int quantum(PCB *pcb) {
+	return getUserQuantum(pcb->priority);
+}
+
+static bool preempts(PCB *pcb, PCB *running) {
+	return pcb->priority < running->priority;
+}
+
+static void onTick(PCB *pcb, long used) {
+	if (pcb->priority == 0) { /* Process is real-time */
+		push(active[pcb->processor], pcb);
+		return;
+	}
+
+	/* Determine if this process can shift priority */
+	int n = getQueueQuantum(pcb->priority);
+	if (n != -1 && getNanoseconds(&pcb->queue) >= n) {
+		if (pcb->priority < QUEUE_SET_COUNT - 1) pcb->priority++;
+		clearTime(&pcb->queue);
+	}
+
+	push(expired[pcb->processor], pcb);
+}
+
+/* A process that was preempted hasn't had its turn yet, so it stays in the active set at the same priority */
+static void onPreempt(PCB *pcb, long used) {
+	push(active[pcb->processor], pcb);
+}
+
+static void onBlock(PCB *pcb, long used) {}
+
+static void onUnblock(PCB *pcb) {
+	push(active[pcb->processor], pcb);
+}
+
+static void onExit(PCB *pcb, long used) {}
+
+SchedulerOps mlfqScheduler = {
+	.name = "mlfq",
+	.initialize = initialize,
+	.enqueue = enqueue,
+	.dequeue = dequeue,
+	.pick_next = pickNext,
+	.steal = steal,
+	.load = load,
+	.depth = depth,
+	.quantum = quantum,
+	.preempts = preempts,
+	.on_tick = onTick,
+	.on_preempt = onPreempt,
+	.on_block = onBlock,
+	.on_unblock = onUnblock,
+	.on_exit = onExit
+};
@@ -3,7 +3,10 @@
  * Jared Diehl (jmddnb@umsystem.edu)
  */
 
+#include <errno.h>
 #include <getopt.h>
+#include <libgen.h>
+#include <limits.h>
 #include <signal.h>
 #include <stdbool.h>
 #include <stdio.h>
@@ -16,45 +19,167 @@
 #include <time.h>
 #include <unistd.h>
 
+#include "arrival.h"
+#include "batch.h"
+#include "disk.h"
+#include "controller.h"
+#include "intake.h"
+#include "calendar.h"
+#include "decision.h"
+#include "fiber.h"
+#include "histogram.h"
 #include "oss.h"
-#include "queue.h"
+#include "pidmap.h"
+#include "scheduler.h"
 #include "shared.h"
+#include "trace.h"
+#include "wheel.h"
 
+/* Simulated CPU */
 typedef struct {
-	Shared *shared;
-	Queue *qset1[QUEUE_SET_COUNT];
-	Queue *qset2[QUEUE_SET_COUNT];
-	Queue **active;
-	Queue **expired;
-	Queue *blocked;
-	Message *message;
 	PCB *running;
-	bv_t vector;
 	Time idle;
+	unsigned int dispatches;
+	unsigned int migrations; /* Dispatches of a process that last ran on, or was queued on, another CPU */
+	unsigned int preemptions;
+	bool awaiting; /* Its process was dispatched, but its decision hasn't come in yet */
+} CPU;
+
+/* Window of the simulation since the sample before it, where times are in nanoseconds */
+typedef struct {
+	long time;
+	long window; /* Time since the sample before it */
+	unsigned int completions;
+	unsigned int dispatches;
+	long idle; /* Every CPU was idle */
+	long busy; /* Summed across CPUs */
+	int quantum; /* Of the top normal queue */
+	unsigned int depths[QUEUE_SET_COUNT]; /* Processes queued at each priority when the sample was taken */
+} Sample;
+
+typedef struct {
+	Shared *shared;
+	SchedulerOps *scheduler;
+	Calendar *calendar;
+	Wheel *wheel; /* Unblock deadlines */
+	WheelTimer *timers; /* Indexed by local PID */
+	Message *message;
+	CPU *cpus;
+	unsigned int cpuCount;
+	Fiber **fibers; /* User processes run as coroutines, indexed by local PID */
+	bool coroutines;
+	pid_t *workers; /* Pre-forked user processes */
+	pid_t *pool; /* Pre-forked user processes not assigned a local PID */
+	unsigned int poolSize;
+	bool pooled;
+	bool rings;
+	bool pipelined;
+	IntakeQueue *intake; /* Decisions taken off the message queue by another thread, if pipelined */
+	unsigned int inflight; /* CPUs awaiting a decision */
+	bool verbose;
+	Trace *trace; /* Log being replayed, if any */
+	char *tracePath;
+	Job job; /* Next job of the log to spawn */
+	bool jobPending;
+	long traceStart; /* Submit time of the first job, in seconds */
+	long traceScale; /* Simulated microseconds per second of the log */
+	unsigned int batchSize; /* Processors of the batch partition, or 0 if not running as one */
+	Batch *batch;
+	BatchJob **batchJobs; /* Running jobs, indexed by slot */
+	PidMap *batchSlots; /* Free slots */
+	unsigned long batchSkipped; /* Jobs wider than the partition */
+	double batchWork; /* Processor-nanoseconds of every finished job */
+	double slowdownTotal;
+	Histogram *batchWaits;
+	Histogram *slowdowns; /* Bounded slowdowns, in thousandths */
+	Disk *disks; /* Serve blocked processes, if any */
+	unsigned int diskCount;
+	int diskPolicy;
+	DiskRequest *requests; /* Indexed by local PID */
+	Histogram *ioLatencies; /* From a request being queued until it's served */
+	long refillAt; /* Time of the refill event in the calendar, or -1 if there's none */
+	Controller controller;
+	bool controlling;
+	double quantum; /* Milliseconds of the top normal queue's quantum, or 0 for the default */
+	unsigned int seed; /* Of the whole simulation, or 0 to seed it from the clock */
+	char *summaryPath; /* Where the summary's figures are written, if anywhere */
+	char *userPath; /* Program forked for each user process */
+	unsigned int periodic; /* Periodic events in the calendar, which mustn't keep each other going once nothing else is left */
+	unsigned int processTotal;
+	unsigned int concurrency;
+	unsigned int timeout;
+	PidMap *pids; /* Free local PIDs */
+	Time idle; /* Time every CPU was idle */
+	Arrival arrival;
+	char *arrivalSpec;
 	Time nextSpawnAttempt;
+	Time lastSpawn;
+	bool spawnDeferred;
 	unsigned int spawnedProcessCount;
 	unsigned int exitedProcessCount;
 	Time totalCpu;
 	Time totalBlock;
 	Time totalWait;
+	Histogram *latencies[CLASS_COUNT][METRIC_COUNT];
+	long sampleInterval; /* 0 if not sampling */
+	Sample *samples; /* Ring of the latest samples */
+	unsigned int sampleCount; /* Samples ever taken */
+	Sample totals; /* Running totals as of the latest sample */
+	unsigned int events;
 	int processCountRealtime;
 	int processCountNormal;
+	int processCountRejected; /* Real-time processes that failed admission */
 } Global;
 
 void initializeProgram(int, char**);
 void simulateOS();
+void simulateBatch();
+bool readBatchJob();
+void submitBatchJob();
+void startBatchJobs();
+void finishBatchJob(BatchJob*);
+void printBatchSummary();
+bool nextEvent(Event*);
+void advanceClock(Time*);
+void handleEvent(Event*);
 bool canSchedule();
 bool canSpawnProcess();
 void trySpawnProcess();
 void spawnProcess();
+pid_t forkUser(unsigned int);
+void createWorkerPool();
+void releaseWorkerPool();
+pid_t assignWorker(unsigned int);
 void initializePCB(PCB*, unsigned int, pid_t);
+void admitProcess(PCB*);
 void releasePCB(PCB*);
-void handleProcessScheduling();
-void handleRunningProcess();
-void handleBlockedProcesses();
+void simulateUserCoroutine(void*);
+void handleRunningProcess(PCB*);
+void handleBlockedProcess(PCB*);
+void handleExitedProcess(PCB*);
 void tryScheduleProcess();
-void trySwapQueueSets();
-void scheduleProcess(PCB*);
+void tryRefillGroups();
+void adjustQuanta();
+bool isSimulationDone();
+PCB *stealProcess(unsigned int);
+void scheduleProcess(unsigned int, PCB*);
+void tryPreemptProcess(PCB*);
+void preemptProcess(unsigned int);
+void receiveDecision(PCB*);
+void startQuantum(PCB*);
+bool takeDecision(bool);
+void awaitDecisions();
+void awaitDecision(unsigned int);
+long getHorizon();
+void replayDecision(PCB*);
+long getTraceTime(long);
+int getDecisionCost(PCB*);
+int getRunTime(PCB*);
+void printLatencies();
+void writeSummary(long);
+void publishStats();
+void takeSample();
+void writeSamples();
 void cleanupResources(bool);
 void handleSignal(int);
 
@@ -64,29 +189,32 @@ void onProcessTerminated(PCB*);
 void onProcessExpired(PCB*);
 void onProcessBlocked(PCB*);
 void onProcessUnblocked(PCB*);
+bool setDisks(char*);
+void submitRequest(PCB*);
+void startRequest(Disk*);
+void handleRequest(PCB*);
+void printDisks(long);
+void printGroups(long);
 void onProcessExited(PCB*);
 
 int findAvailableLocalPID();
 PCB *getPCB(unsigned int);
+unsigned int getIdlestCPU();
 bool isProcessRunning();
 bool isProcessRealtime(PCB*);
-
-void initializeQueues();
-void swapRunSets();
-Queue **getActiveSet();
-void setActiveSet(Queue**);
-Queue **getExpiredSet();
-void setExpiredSet(Queue**);
-Queue *getBlockedQueue();
+SchedulerOps *getSchedulerClass(PCB*);
+bool shouldPreempt(PCB*, PCB*);
 
 static Global *global = NULL;
 
 static volatile bool quit = false;
 
 int main(int argc, char **argv) {
-	global = (Global*) malloc(sizeof(Global));
+	global = (Global*) calloc(1, sizeof(Global));
 	initializeProgram(argc, argv);
-	simulateOS();
+	if (global->batchSize > 0) simulateBatch();
+	else simulateOS();
+	releaseWorkerPool();
 	cleanupResources(false);
 	return EXIT_SUCCESS;
 }
@@ -100,12 +228,135 @@ void initializeProgram(int argc, char **argv) {
 	
 	bool ok = true;
 	
+	global->processTotal = PROCESSES_TOTAL_MAX;
+	global->concurrency = PROCESSES_CONCURRENT_MAX;
+	global->cpuCount = 1;
+	global->scheduler = &mlfqScheduler;
+	global->timeout = TIMEOUT;
+	global->arrivalSpec = "uniform";
+	arrival_init(&global->arrival, global->arrivalSpec);
+	global->traceScale = TRACE_SCALE;
+	bool totalSet = false, timeoutSet = false, policySet = false, groups = false;
+	
 	while (true) {
-		int c = getopt(argc, argv, "h");
+		int c = getopt(argc, argv, "hcwjrva:b:d:e:f:g:i:m:n:o:p:q:s:t:u:x:");
 		if (c == -1) break;
 		switch (c) {
 			case 'h':
 				usage(EXIT_SUCCESS);
+			case 'c':
+				global->coroutines = true;
+				break;
+			case 'w':
+				global->pooled = true;
+				break;
+			case 'j':
+				global->pipelined = true;
+				break;
+			case 'r':
+				global->rings = true;
+				break;
+			case 'v':
+				global->verbose = true;
+				break;
+			case 'a':
+				if (!arrival_init(&global->arrival, optarg)) {
+					error("invalid arrival process '%s'", optarg);
+					ok = false;
+				} else global->arrivalSpec = optarg;
+				break;
+			case 'b':
+				if (atoi(optarg) < 1 || atoi(optarg) > BATCH_PROCESSORS_MAX) {
+					error("invalid batch partition size '%s' (1-%d)", optarg, BATCH_PROCESSORS_MAX);
+					ok = false;
+				} else global->batchSize = atoi(optarg);
+				break;
+			case 'd':
+				if (!setDisks(optarg)) {
+					error("invalid disks '%s'", optarg);
+					ok = false;
+				}
+				break;
+			case 'e':
+				if (atol(optarg) < 1 || atol(optarg) > UINT_MAX) {
+					error("invalid seed '%s'", optarg);
+					ok = false;
+				} else global->seed = atol(optarg);
+				break;
+			case 'f':
+				global->tracePath = optarg;
+				break;
+			case 'i':
+				if (atoi(optarg) < 1) {
+					error("invalid sample interval '%s'", optarg);
+					ok = false;
+				} else global->sampleInterval = atol(optarg) * 1000000;
+				break;
+			case 'm':
+				if (atoi(optarg) < 1 || atoi(optarg) > CPUS_MAX) {
+					error("invalid CPU count '%s' (1-%d)", optarg, CPUS_MAX);
+					ok = false;
+				} else global->cpuCount = atoi(optarg);
+				break;
+			case 'n':
+				if (atoi(optarg) < 1) {
+					error("invalid process total '%s'", optarg);
+					ok = false;
+				} else {
+					global->processTotal = atoi(optarg);
+					totalSet = true;
+				}
+				break;
+			case 'o':
+				global->summaryPath = optarg;
+				break;
+			case 'p':
+				if ((global->scheduler = getScheduler(optarg)) == NULL) {
+					error("invalid policy '%s'", optarg);
+					ok = false;
+				}
+				policySet = true;
+				break;
+			case 'g':
+				if (!setGroups(optarg)) {
+					error("invalid groups '%s' (at most %d)", optarg, GROUPS_MAX);
+					ok = false;
+				}
+				groups = true;
+				break;
+			case 'q':
+				if (!controller_init(&global->controller, optarg)) {
+					error("invalid quantum controller '%s'", optarg);
+					ok = false;
+				} else global->controlling = true;
+				break;
+			case 's':
+				if (atoi(optarg) < 1) {
+					error("invalid concurrency '%s'", optarg);
+					ok = false;
+				} else global->concurrency = atoi(optarg);
+				break;
+			case 't':
+				if (atoi(optarg) < 1) {
+					error("invalid timeout '%s'", optarg);
+					ok = false;
+				} else {
+					global->timeout = atoi(optarg);
+					timeoutSet = true;
+				}
+				break;
+			case 'u':
+				if (atof(optarg) <= 0) {
+					error("invalid quantum '%s'", optarg);
+					ok = false;
+				} else global->quantum = atof(optarg);
+				break;
+			case 'x':
+				if (atoi(optarg) < 1) {
+					error("invalid trace scale '%s'", optarg);
+					ok = false;
+				} else global->traceScale = atol(optarg);
+				break;
 			default:
 				ok = false;
 		}
@@ -122,14 +373,97 @@ void initializeProgram(int argc, char **argv) {
 		ok = false;
 	}
 	
+	if (global->coroutines && global->pooled) {
+		error("options -c and -w can't be used together");
+		ok = false;
+	}
+	
+	if (global->coroutines && global->rings) {
+		error("options -c and -r can't be used together");
+		ok = false;
+	}
+	
+	if (global->tracePath != NULL && (global->coroutines || global->pooled || global->rings)) {
+		error("option -f can't be used with -c, -w or -r");
+		ok = false;
+	}
+	
+	if (global->tracePath != NULL && strcmp(global->arrivalSpec, "uniform") != 0) {
+		error("options -a and -f can't be used together");
+		ok = false;
+	}
+	
+	if (global->batchSize > 0 && global->tracePath == NULL) {
+		error("option -b needs a log to replay with -f");
+		ok = false;
+	}
+	
+	if (groups && policySet) {
+		error("option -g picks the group policy, so it can't be used with -p");
+		ok = false;
+	} else if (groups) global->scheduler = &groupScheduler;
+	
+	if (global->pipelined && (global->coroutines || global->rings || global->tracePath != NULL)) {
+		error("option -j only pipelines message queues, so it can't be used with -c, -r or -f");
+		ok = false;
+	}
+	
+	if (global->controlling && global->scheduler == &cfsScheduler) {
+		error("option -q can't be used with cfs, which sizes its own slices");
+		ok = false;
+	}
+	
+	if (global->quantum > 0 && (global->controlling || global->scheduler == &cfsScheduler)) {
+		error("option -u can't be used with -q or cfs, which size quanta themselves");
+		ok = false;
+	}
+	
+	if (global->summaryPath != NULL && global->batchSize > 0) {
+		error("option -o can't be used with -b, which has a summary of its own");
+		ok = false;
+	}
+	
+	if (global->diskCount > 0 && global->tracePath != NULL) {
+		error("option -d can't be used with -f, since replayed jobs never block");
+		ok = false;
+	}
+	
+	if (global->tracePath != NULL && (global->trace = trace_open(global->tracePath)) == NULL) {
+		error("can't open trace '%s': %s", global->tracePath, strerror(errno));
+		ok = false;
+	}
+	
 	if (!ok) usage(EXIT_FAILURE);
 	
-	timer(TIMEOUT);
+	/* A replay runs until the log is done, and logs nothing unless asked, so it's only as slow as the scheduling */
+	if (global->trace != NULL) {
+		if (!totalSet) global->processTotal = UINT_MAX;
+		if (!timeoutSet) global->timeout = 0;
+		setLogging(global->verbose);
+	}
+	
+	timer(global->timeout);
+	setVerbose(global->verbose);
+	
+	/* User processes are run from wherever OSS is, so OSS can be run from any working directory */
+	char *path = strdup(argv[0]);
+	global->userPath = (char*) malloc(BUFFER_LENGTH);
+	snprintf(global->userPath, BUFFER_LENGTH, "%s/%s", dirname(path), PATH_USER);
+	free(path);
 	
-	allocateSharedMemory(true);
-	allocateMessageQueues(true);
+	/* User processes running as coroutines, or replayed jobs, don't need any IPC */
+	if (global->coroutines || global->trace != NULL) allocatePrivateMemory(global->concurrency);
+	else {
+		allocateSharedMemory(true, global->concurrency);
+		allocateMessageQueues(true);
+	}
 	
 	global->shared = getSharedMemory();
+	global->shared->transport = global->rings ? TRANSPORT_RING : TRANSPORT_MESSAGE;
+	global->shared->disks = global->diskCount > 0;
+	
+	/* Readable by ossstat while the simulation runs, however user processes are run */
+	allocateStatsMemory(getpid());
 	
 	/* Clear log file */
 	FILE *fp;
@@ -140,40 +474,114 @@ void initializeProgram(int argc, char **argv) {
 void simulateOS() {
 	global->message = (Message*) malloc(sizeof(Message));
 	
-	initializeQueues();
+	global->cpus = (CPU*) calloc(global->cpuCount, sizeof(CPU));
+	edfScheduler.initialize(global->cpuCount, global->concurrency);
+	global->scheduler->initialize(global->cpuCount, global->concurrency);
+	global->calendar = calendar_create(CALENDAR_SIZE);
+	global->wheel = wheel_create();
+	global->pids = pidmap_create(global->concurrency);
+	global->timers = (WheelTimer*) calloc(global->concurrency + 1, sizeof(WheelTimer));
+	global->fibers = (Fiber**) calloc(global->concurrency + 1, sizeof(Fiber*));
+	global->refillAt = -1;
+	initializeQuanta();
+	
+	/* A fixed quantum keeps the other normal queues' ratios to it */
+	if (global->quantum > 0) scaleQuanta(global->quantum * 1e6 / getDefaultQuantum(1));
+	
+	if (global->diskCount > 0) {
+		global->disks = (Disk*) calloc(global->diskCount, sizeof(Disk));
+		unsigned int i;
+		for (i = 0; i < global->diskCount; i++)
+			disk_initialize(&global->disks[i], global->diskPolicy);
+		global->requests = (DiskRequest*) calloc(global->concurrency + 1, sizeof(DiskRequest));
+		global->ioLatencies = histogram_create();
+	}
+	
+	int class, metric;
+	for (class = 0; class < CLASS_COUNT; class++)
+		for (metric = 0; metric < METRIC_COUNT; metric++)
+			global->latencies[class][metric] = histogram_create();
 	
 	setTime(&global->shared->system, 0);
 	setTime(&global->nextSpawnAttempt, 0);
 	
-	srand(time(NULL));
+	srand(global->seed != 0 ? global->seed : time(NULL));
 	
-	while (true) {
-		addTime(&global->shared->system, 1e4);
-		addTime(&global->idle, 1e4);
-		
-		handleProcessScheduling();
-		
-		/* Check if an actual user process has terminated */
-		int status;
-		pid_t pid = waitpid(-1, &status, WNOHANG);
-		if (pid > 0) {
-			if (WIFEXITED(status)) {
-				if (WEXITSTATUS(status) > EXIT_STATUS_OFFSET) {
-					int localPID = WEXITSTATUS(status) - EXIT_STATUS_OFFSET;
-					PCB *pcb = getPCB(localPID);
-					onProcessExited(pcb);
-				}
-			}
-		}
-		
-		if (!canSchedule()) break;
+	if (global->pooled) createWorkerPool();
+	
+	/* The first process is spawned at the very start of the simulation, or when the first job of the log was submitted */
+	if (global->trace != NULL) {
+		global->jobPending = trace_next(global->trace, &global->job);
+		global->traceStart = global->job.submit;
+	}
+	if (global->trace == NULL || global->jobPending) calendar_push(global->calendar, EVENT_SPAWN, &global->nextSpawnAttempt, 0);
+	
+	if (global->sampleInterval > 0) {
+		global->samples = (Sample*) calloc(SAMPLES_MAX, sizeof(Sample));
+		Time time;
+		setTime(&time, global->sampleInterval);
+		calendar_push(global->calendar, EVENT_SAMPLE, &time, 0);
+		global->periodic++;
+	}
+	
+	if (global->controlling) {
+		Time time;
+		setTime(&time, CONTROLLER_INTERVAL);
+		calendar_push(global->calendar, EVENT_CONTROL, &time, 0);
+		global->periodic++;
+	}
+	
+	/* Jump from event to event instead of ticking through the time in between */
+	Event event;
+	if (global->pipelined) global->intake = intake_start(getParentQueue());
+	while (canSchedule()) {
+		if (global->pipelined) awaitDecisions();
+		if (!nextEvent(&event)) break;
+		advanceClock(&event.time);
+		handleEvent(&event);
+		tryScheduleProcess();
+		tryRefillGroups();
+		if (++global->events % STATS_EVENTS == 0) publishStats();
 	}
+	publishStats();
 	
 	if (quit) printf("TIMEOUT REACHED\n\n");
 	
+	if (global->sampleInterval > 0) {
+		takeSample();
+		writeSamples();
+	}
+	
+	if (global->summaryPath != NULL) writeSummary(getNanoseconds(&global->shared->system));
+	
 	printf("SUMMARY\n");
+	printf("\tPolicy: %s\n", global->scheduler->name);
+	if (global->controlling || global->quantum > 0) {
+		if (global->controlling) printf("\tQuanta: %u adjustments, %.2fx, now", global->controller.adjustments, global->controller.scale);
+		else printf("\tQuanta: fixed at");
+		int queue;
+		for (queue = 1; queue < QUEUE_SET_COUNT; queue++) printf(" %.2f", getUserQuantum(queue) / 1e6);
+		printf(" ms\n");
+	}
+	printf("\tCPUs: %u\n", global->cpuCount);
 	printf("\tReal-time processes: %d\n", global->processCountRealtime);
 	printf("\tNormal processes: %d\n", global->processCountNormal);
+	printf("\tReal-time rejected: %d\n", global->processCountRejected);
+	printf("\tDeadline misses: %u\n", getDeadlineMisses());
+	long system = getNanoseconds(&global->shared->system);
+	if (global->trace != NULL) printf("\tArrivals: %s, %lu jobs skipped\n", global->tracePath, global->trace->skipped);
+	else printf("\tArrivals: %s, %.2f processes/s offered\n", global->arrivalSpec, arrival_rate(&global->arrival));
+	long spawned = getNanoseconds(&global->lastSpawn);
+	printf("\tArrival rate: %.2f processes/s\n", spawned > 0 ? (global->spawnedProcessCount - 1) / (spawned / 1e9) : 0);
+	printf("\tThroughput: %.2f processes/s\n", system > 0 ? global->exitedProcessCount / (system / 1e9) : 0);
+	
+	printf("CPUS\n");
+	unsigned int i;
+	for (i = 0; i < global->cpuCount; i++) {
+		CPU *cpu = &global->cpus[i];
+		double utilization = system > 0 ? 100.0 * (system - getNanoseconds(&cpu->idle)) / system : 0;
+		printf("\t%2u: Utilization: %5.1f%%, Dispatches: %u, Migrations: %u, Preemptions: %u\n", i, utilization, cpu->dispatches, cpu->migrations, cpu->preemptions);
+	}
 	
 	printf("TOTALS\n");
 	printf("\tCPU:    %ld:%ld\n", global->totalCpu.sec, global->totalCpu.ns);
@@ -182,18 +590,323 @@ void simulateOS() {
 	printf("\tSystem: %ld:%ld\n", global->shared->system.sec, global->shared->system.ns);
 	printf("\tIdle:   %ld:%ld\n", global->idle.sec, global->idle.ns);
 	
-	avgTime(&global->totalCpu, global->exitedProcessCount);
-	avgTime(&global->totalBlock, global->exitedProcessCount);
-	avgTime(&global->totalWait, global->exitedProcessCount);
-	avgTime(&global->shared->system, global->exitedProcessCount);
-	avgTime(&global->idle, global->exitedProcessCount);
+	/* Nothing to average over if no process exited, like when every job of a trace was skipped */
+	if (global->exitedProcessCount > 0) {
+		avgTime(&global->totalCpu, global->exitedProcessCount);
+		avgTime(&global->totalBlock, global->exitedProcessCount);
+		avgTime(&global->totalWait, global->exitedProcessCount);
+		avgTime(&global->shared->system, global->exitedProcessCount);
+		avgTime(&global->idle, global->exitedProcessCount);
+		
+		printf("AVERAGES\n");
+		printf("\tCPU:    %ld:%ld\n", global->totalCpu.sec, global->totalCpu.ns);
+		printf("\tBlock:  %ld:%ld\n", global->totalBlock.sec, global->totalBlock.ns);
+		printf("\tWait:   %ld:%ld\n", global->totalWait.sec, global->totalWait.ns);
+		printf("\tSystem: %ld:%ld\n", global->shared->system.sec, global->shared->system.ns);
+		printf("\tIdle:   %ld:%ld\n", global->idle.sec, global->idle.ns);
+	}
 	
-	printf("AVERAGES\n");
-	printf("\tCPU:    %ld:%ld\n", global->totalCpu.sec, global->totalCpu.ns);
-	printf("\tBlock:  %ld:%ld\n", global->totalBlock.sec, global->totalBlock.ns);
-	printf("\tWait:   %ld:%ld\n", global->totalWait.sec, global->totalWait.ns);
-	printf("\tSystem: %ld:%ld\n", global->shared->system.sec, global->shared->system.ns);
-	printf("\tIdle:   %ld:%ld\n", global->idle.sec, global->idle.ns);
+	printLatencies();
+	if (global->diskCount > 0) printDisks(system);
+	if (global->scheduler == &groupScheduler) printGroups(system);
+}
+
+void printLatencies() {
+	static char *classes[] = { "Real-time", "Normal" };
+	static char *metrics[] = { "Wait:", "Block:", "CPU:", "Turnaround:", "Response:" };
+	static double percentiles[] = { 50, 90, 99, 99.9 };
+	
+	printf("PERCENTILES\n");
+	int i, j, k;
+	for (i = 0; i < CLASS_COUNT; i++) {
+		printf("\t%s (%lu processes)\n", classes[i], global->latencies[i][0]->total);
+		if (global->latencies[i][0]->total == 0) continue;
+		printf("\t\t%-11s %-14s %-14s %-14s %s\n", "", "p50", "p90", "p99", "p99.9");
+		for (j = 0; j < METRIC_COUNT; j++) {
+			printf("\t\t%-11s", metrics[j]);
+			for (k = 0; k < 4; k++) {
+				Time time;
+				char buf[BUFFER_LENGTH];
+				setTime(&time, histogram_percentile(global->latencies[i][j], percentiles[k]));
+				snprintf(buf, BUFFER_LENGTH, "%ld:%ld", time.sec, time.ns);
+				printf(k < 3 ? " %-14s" : " %s", buf);
+			}
+			printf("\n");
+		}
+	}
+}
+
+/*
+ * Writes the figures of the summary as name,value lines, for a sweep to read back. Times are in seconds, and
+ * percentiles are only written for a class that had processes terminate.
+ */
+void writeSummary(long system) {
+	static char *classes[] = { "realtime", "normal" };
+	static char *metrics[] = { "wait", "block", "cpu", "turnaround", "response" };
+	static double percentiles[] = { 50, 90, 99, 99.9 };
+	static char *labels[] = { "p50", "p90", "p99", "p999" };
+	
+	FILE *fp;
+	if ((fp = fopen(global->summaryPath, "w")) == NULL) crash("fopen");
+	
+	unsigned int exited = global->exitedProcessCount, dispatches = 0, migrations = 0, preemptions = 0;
+	long busy = 0;
+	unsigned int i;
+	for (i = 0; i < global->cpuCount; i++) {
+		dispatches += global->cpus[i].dispatches;
+		migrations += global->cpus[i].migrations;
+		preemptions += global->cpus[i].preemptions;
+		busy += system - getNanoseconds(&global->cpus[i].idle);
+	}
+	long spawned = getNanoseconds(&global->lastSpawn);
+	
+	fprintf(fp, "time,%.9f\n", system / 1e9);
+	fprintf(fp, "processes,%u\n", exited);
+	fprintf(fp, "realtime,%d\n", global->processCountRealtime);
+	fprintf(fp, "normal,%d\n", global->processCountNormal);
+	fprintf(fp, "rejected,%d\n", global->processCountRejected);
+	fprintf(fp, "deadline_misses,%u\n", getDeadlineMisses());
+	fprintf(fp, "arrival_rate,%.4f\n", spawned > 0 ? (global->spawnedProcessCount - 1) / (spawned / 1e9) : 0);
+	fprintf(fp, "throughput,%.4f\n", system > 0 ? exited / (system / 1e9) : 0);
+	fprintf(fp, "utilization,%.4f\n", system > 0 ? 100.0 * busy / system / global->cpuCount : 0);
+	fprintf(fp, "dispatches,%u\n", dispatches);
+	fprintf(fp, "migrations,%u\n", migrations);
+	fprintf(fp, "preemptions,%u\n", preemptions);
+	fprintf(fp, "quantum,%.6f\n", getUserQuantum(1) / 1e6);
+	if (exited > 0) {
+		fprintf(fp, "cpu,%.9f\n", getNanoseconds(&global->totalCpu) / 1e9 / exited);
+		fprintf(fp, "block,%.9f\n", getNanoseconds(&global->totalBlock) / 1e9 / exited);
+		fprintf(fp, "wait,%.9f\n", getNanoseconds(&global->totalWait) / 1e9 / exited);
+	}
+	
+	int j, k;
+	for (i = 0; i < CLASS_COUNT; i++) {
+		if (global->latencies[i][0]->total == 0) continue;
+		for (j = 0; j < METRIC_COUNT; j++)
+			for (k = 0; k < 4; k++)
+				fprintf(fp, "%s_%s_%s,%.9f\n", classes[i], metrics[j], labels[k], histogram_percentile(global->latencies[i][j], percentiles[k]) / 1e9);
+	}
+	
+	if (fclose(fp) == EOF) crash("fclose");
+}
+
+/*
+ * Replays the log as rigid jobs on a batch partition instead of as processes sharing CPUs. A job holds the
+ * processors it asked for from when it starts until it finishes, and jobs start in order except when EASY
+ * backfilling can start one early without delaying the job at the head of the queue.
+ */
+void simulateBatch() {
+	global->calendar = calendar_create(CALENDAR_SIZE);
+	global->batch = batch_create(global->batchSize);
+	global->batchJobs = (BatchJob**) calloc(global->batchSize, sizeof(BatchJob*));
+	global->batchSlots = pidmap_create(global->batchSize);
+	global->batchWaits = histogram_create();
+	global->slowdowns = histogram_create();
+	
+	setTime(&global->shared->system, 0);
+	
+	if ((global->jobPending = readBatchJob())) {
+		global->traceStart = global->job.submit;
+		calendar_push(global->calendar, EVENT_SPAWN, &global->shared->system, 0);
+	}
+	
+	Event event;
+	while (calendar_pop(global->calendar, &event)) {
+		copyTime(&event.time, &global->shared->system);
+		if (event.type == EVENT_SPAWN) submitBatchJob();
+		else finishBatchJob(global->batchJobs[event.localPID]);
+		startBatchJobs();
+	}
+	
+	if (quit) printf("TIMEOUT REACHED\n\n");
+	
+	printBatchSummary();
+}
+
+/* Reads the next job of the log that fits on the partition at all */
+bool readBatchJob() {
+	if (quit || global->spawnedProcessCount >= global->processTotal) return false;
+	while (trace_next(global->trace, &global->job)) {
+		if (global->job.processors <= global->batchSize) return true;
+		global->batchSkipped++;
+	}
+	return false;
+}
+
+void submitBatchJob() {
+	BatchJob *job = (BatchJob*) calloc(1, sizeof(BatchJob));
+	job->width = global->job.processors;
+	job->submit = getNanoseconds(&global->shared->system);
+	job->run = getTraceTime(global->job.run);
+	job->estimate = getTraceTime(global->job.estimate);
+	batch_submit(global->batch, job);
+	
+	global->spawnedProcessCount++;
+	copyTime(&global->shared->system, &global->lastSpawn);
+	logger("%-6s Processors: %u, Estimate: %ld", "*-----", job->width, job->estimate);
+	
+	if ((global->jobPending = readBatchJob())) {
+		setTime(&global->nextSpawnAttempt, getTraceTime(global->job.submit - global->traceStart));
+		calendar_push(global->calendar, EVENT_SPAWN, &global->nextSpawnAttempt, 0);
+	}
+}
+
+/* Every running job has at least one processor, so there's always a free slot for one that starts */
+void startBatchJobs() {
+	long now = getNanoseconds(&global->shared->system);
+	BatchJob *job = batch_schedule(global->batch, now), *next;
+	for (; job != NULL; job = next) {
+		next = job->next;
+		job->slot = pidmap_allocate(global->batchSlots);
+		global->batchJobs[job->slot] = job;
+		
+		Time time;
+		setTime(&time, now + job->run);
+		calendar_push(global->calendar, EVENT_EXIT, &time, job->slot);
+		logger("%-6s Processors: %u, Wait: %ld", "-*----", job->width, now - job->submit);
+	}
+}
+
+void finishBatchJob(BatchJob *job) {
+	batch_finish(global->batch, job);
+	pidmap_release(global->batchSlots, job->slot);
+	global->exitedProcessCount++;
+	
+	/* Bounded slowdown, so jobs too short to matter don't swamp it */
+	long wait = job->start - job->submit;
+	double slowdown = (double) (wait + job->run) / MAX(job->run, getTraceTime(SLOWDOWN_THRESHOLD));
+	if (slowdown < 1) slowdown = 1;
+	
+	histogram_record(global->batchWaits, wait);
+	histogram_record(global->slowdowns, (long) (slowdown * 1000));
+	global->slowdownTotal += slowdown;
+	global->batchWork += (double) job->run * job->width;
+	
+	logger("%-6s Processors: %u, Slowdown: %.2f", "-----*", job->width, slowdown);
+	free(job);
+}
+
+void printBatchSummary() {
+	static double percentiles[] = { 50, 90, 99, 99.9 };
+	long system = getNanoseconds(&global->shared->system);
+	unsigned int jobs = global->exitedProcessCount;
+	
+	printf("SUMMARY\n");
+	printf("\tPolicy: easy\n");
+	printf("\tProcessors: %u\n", global->batchSize);
+	printf("\tJobs: %u\n", jobs);
+	printf("\tBackfilled: %lu\n", global->batch->backfilled);
+	printf("\tArrivals: %s, %lu jobs skipped\n", global->tracePath, global->trace->skipped + global->batchSkipped);
+	printf("\tUtilization: %.1f%%\n", system > 0 ? 100.0 * global->batchWork / ((double) system * global->batchSize) : 0);
+	printf("\tThroughput: %.2f jobs/s\n", system > 0 ? jobs / (system / 1e9) : 0);
+	printf("\tBounded slowdown: %.2f\n", jobs > 0 ? global->slowdownTotal / jobs : 0);
+	
+	if (jobs == 0) return;
+	printf("PERCENTILES\n");
+	printf("\t%-11s %-14s %-14s %-14s %s\n", "", "p50", "p90", "p99", "p99.9");
+	printf("\t%-11s", "Wait:");
+	int i;
+	for (i = 0; i < 4; i++) {
+		Time time;
+		char buf[BUFFER_LENGTH];
+		setTime(&time, histogram_percentile(global->batchWaits, percentiles[i]));
+		snprintf(buf, BUFFER_LENGTH, "%ld:%ld", time.sec, time.ns);
+		printf(i < 3 ? " %-14s" : " %s", buf);
+	}
+	printf("\n\t%-11s", "Slowdown:");
+	for (i = 0; i < 4; i++) {
+		char buf[BUFFER_LENGTH];
+		snprintf(buf, BUFFER_LENGTH, "%.2f", histogram_percentile(global->slowdowns, percentiles[i]) / 1000.0);
+		printf(i < 3 ? " %-14s" : " %s", buf);
+	}
+	printf("\n");
+}
+
+/* Gets whichever comes first, the next calendar event or the next unblock deadline on the timer wheel */
+bool nextEvent(Event *event) {
+	unsigned long expiry;
+	bool timer = wheel_next(global->wheel, &expiry);
+	Event *next = calendar_peek(global->calendar);
+	
+	if (next == NULL && !timer) return false;
+	
+	if (next != NULL && (!timer || getNanoseconds(&next->time) <= expiry)) {
+		calendar_pop(global->calendar, event);
+		wheel_advance(global->wheel, getNanoseconds(&event->time));
+		return true;
+	}
+	
+	/* Only the timers that fire now are touched, however many processes are blocked */
+	wheel_advance(global->wheel, expiry);
+	WheelTimer *fired = wheel_pop(global->wheel);
+	setTime(&event->time, expiry);
+	event->sequence = 0;
+	event->type = EVENT_UNBLOCK;
+	event->localPID = fired->localPID;
+	return true;
+}
+
+/* Moves the system clock forward to the given time, counting the gap as idle on every CPU with nothing running */
+void advanceClock(Time *time) {
+	Time *system = &global->shared->system;
+	if (compareTime(time, system) <= 0) return;
+	
+	Time elapsed = subtractTime(time, system);
+	unsigned int i;
+	for (i = 0; i < global->cpuCount; i++)
+		if (global->cpus[i].running == NULL) addTime(&global->cpus[i].idle, elapsed.sec * 1e9 + elapsed.ns);
+	if (!isProcessRunning()) addTime(&global->idle, elapsed.sec * 1e9 + elapsed.ns);
+	
+	copyTime(time, system);
+}
+
+void handleEvent(Event *event) {
+	switch (event->type) {
+		case EVENT_SPAWN:
+			trySpawnProcess();
+			break;
+		case EVENT_QUANTUM:
+			handleRunningProcess(getPCB(event->localPID));
+			break;
+		case EVENT_UNBLOCK:
+			handleBlockedProcess(getPCB(event->localPID));
+			break;
+		case EVENT_EXIT:
+			handleExitedProcess(getPCB(event->localPID));
+			break;
+		case EVENT_IO:
+			handleRequest(getPCB(event->localPID));
+			break;
+		case EVENT_REFILL:
+			/* Nothing to do but let the CPUs pick again, now that quotas have been refilled */
+			global->refillAt = -1;
+			break;
+		case EVENT_SAMPLE:
+			takeSample();
+			
+			/* Stop once nothing else is left to happen, otherwise sampling would go on forever */
+			global->periodic--;
+			if (!isSimulationDone()) {
+				Time time;
+				copyTime(&global->shared->system, &time);
+				addTime(&time, global->sampleInterval);
+				calendar_push(global->calendar, EVENT_SAMPLE, &time, 0);
+				global->periodic++;
+			}
+			break;
+		case EVENT_CONTROL:
+			adjustQuanta();
+			
+			global->periodic--;
+			if (!isSimulationDone()) {
+				Time time;
+				copyTime(&global->shared->system, &time);
+				addTime(&time, CONTROLLER_INTERVAL);
+				calendar_push(global->calendar, EVENT_CONTROL, &time, 0);
+				global->periodic++;
+			}
+			break;
+	}
 }
 
 bool canSchedule() {
@@ -203,7 +916,8 @@ bool canSchedule() {
 bool canSpawnProcess() {
 	Time *system = &global->shared->system;
 	Time *next = &global->nextSpawnAttempt;
-	return !quit && global->spawnedProcessCount < PROCESSES_TOTAL_MAX && system->sec >= next->sec && system->ns >= next->ns && global->spawnedProcessCount < PROCESSES_TOTAL_MAX;
+	if (global->trace != NULL && !global->jobPending) return false;
+	return !quit && global->spawnedProcessCount < global->processTotal && compareTime(system, next) >= 0;
 }
 
 void trySpawnProcess() {
@@ -213,31 +927,78 @@ void trySpawnProcess() {
 void spawnProcess() {
 	int localPID = findAvailableLocalPID();
 	if (localPID > -1) {
-		BIT_SET(global->vector, localPID - 1);
-		
-		pid_t pid = fork();
-		if (pid == -1) crash("fork");
-		else if (pid == 0) {
-			char buf[BUFFER_LENGTH];
-			snprintf(buf, BUFFER_LENGTH, "%d", localPID);
-			execl("./user", "user", buf, (char*) NULL);
-			crash("execl");
-		}
+		pid_t pid = 0;
+		if (global->pooled) pid = assignWorker(localPID);
+		else if (!global->coroutines && global->trace == NULL) pid = forkUser(localPID);
 		
 		PCB *pcb = getPCB(localPID);
 		initializePCB(pcb, localPID, pid);
+		
+		/* Interactive jobs are the real-time ones */
+		if (global->trace != NULL) {
+			pcb->priority = global->job.queue == 0 ? 0 : 1;
+			pcb->demand = getTraceTime(global->job.run);
+		}
+		
+		admitProcess(pcb);
+		if (global->coroutines) global->fibers[localPID] = fiber_create(simulateUserCoroutine, pcb);
 		onProcessCreated(pcb);
+	} else {
+		/* Try again once a process exits and frees up its PID */
+		global->spawnDeferred = true;
+	}
+}
+
+/* Forks and executes a user process for the local PID, or a pooled worker if 0 */
+pid_t forkUser(unsigned int localPID) {
+	pid_t pid = fork();
+	if (pid == -1) crash("fork");
+	else if (pid == 0) {
+		char buf[BUFFER_LENGTH];
+		snprintf(buf, BUFFER_LENGTH, "%d", localPID);
+		execl(global->userPath, PATH_USER, buf, (char*) NULL);
+		crash("execl");
+	}
+	return pid;
+}
+
+/* Pays for forking user processes once, up front, instead of once per simulated process */
+void createWorkerPool() {
+	global->workers = (pid_t*) calloc(global->concurrency, sizeof(pid_t));
+	global->pool = (pid_t*) calloc(global->concurrency, sizeof(pid_t));
+	
+	int i;
+	for (i = 0; i < global->concurrency; i++) {
+		global->workers[i] = forkUser(0);
+		global->pool[global->poolSize++] = global->workers[i];
 	}
 }
 
+void releaseWorkerPool() {
+	if (!global->pooled) return;
+	
+	/* Assigning local PID 0 tells a worker to exit */
+	int i;
+	for (i = 0; i < global->concurrency; i++)
+		sendMessage(global->message, getChildQueue(), global->workers[i], "0", true);
+	for (i = 0; i < global->concurrency; i++)
+		if (waitpid(global->workers[i], NULL, 0) == -1) crash("waitpid");
+}
+
+/* Hands an idle worker the local PID it will now simulate */
+pid_t assignWorker(unsigned int localPID) {
+	pid_t pid = global->pool[--global->poolSize];
+	char buf[BUFFER_LENGTH];
+	snprintf(buf, BUFFER_LENGTH, "%d", localPID);
+	sendMessage(global->message, getChildQueue(), pid, buf, true);
+	return pid;
+}
+
 void initializePCB(PCB *pcb, unsigned int localPID, pid_t actualPID) {
 	pcb->localPID = localPID;
 	pcb->actualPID = actualPID;
 	pcb->priority = rand() % 100 < CHANCE_PROCESS_REALTIME ? 0 : 1;
 	
-	if (pcb->priority == 0) global->processCountRealtime++;
-	else global->processCountNormal++;
-	
 	clearTime(&pcb->arrival);
 	clearTime(&pcb->exit);
 	clearTime(&pcb->cpu);
@@ -245,99 +1006,440 @@ void initializePCB(PCB *pcb, unsigned int localPID, pid_t actualPID) {
 	clearTime(&pcb->block);
 	clearTime(&pcb->wait);
 	clearTime(&pcb->system);
+	clearTime(&pcb->unblock);
+	pcb->blocked = 0;
+	clearTime(&pcb->response);
+	pcb->dispatches = 0;
+	pcb->decision = DECISION_NONE;
+	pcb->percent = 0;
+	pcb->remaining = 0;
+	pcb->decided = false;
+	pcb->seed = global->seed != 0 ? rand() | 1 : 0;
 	
 	copyTime(&global->shared->system, &pcb->arrival);
 	copyTime(&global->shared->system, &pcb->system);
 }
 
+/* A real-time process only gets deadlines if EDF can still meet all of them, otherwise it runs as a normal process */
+void admitProcess(PCB *pcb) {
+	if (isProcessRealtime(pcb) && !edfScheduler.admit(pcb)) {
+		pcb->priority = 1;
+		global->processCountRejected++;
+	}
+	
+	if (isProcessRealtime(pcb)) global->processCountRealtime++;
+	else global->processCountNormal++;
+}
+
 void releasePCB(PCB *pcb) {
-	BIT_CLEAR(global->vector, pcb->localPID - 1);
+	pidmap_release(global->pids, pcb->localPID - 1);
 	memset(&global->shared->ptable[pcb->localPID], 0, sizeof(PCB));
 }
 
-void handleProcessScheduling() {
-	trySpawnProcess();
-	handleRunningProcess();
-	trySwapQueueSets();
-	handleBlockedProcesses();
-	tryScheduleProcess();
+/*
+ * Same decisions as the user program, but run as a coroutine inside OSS. Each yield hands control back
+ * to OSS the same way the user program would send a message and then wait for a reply.
+ */
+void simulateUserCoroutine(void *argument) {
+	PCB *pcb = (PCB*) argument;
+	
+	while (true) {
+		if (shouldTerminate(pcb)) {
+			pcb->decision = DECISION_TERMINATED;
+			pcb->percent = getUsedPercent();
+			return;
+		} else if (shouldExpire(pcb)) {
+			pcb->decision = DECISION_EXPIRED;
+			pcb->percent = 100;
+			fiber_yield();
+		} else {
+			if (!global->shared->disks) pcb->blocked = getBlockedDuration();
+			pcb->decision = DECISION_BLOCKED;
+			pcb->percent = getUsedPercent();
+			fiber_yield();
+			
+			/* Resumed once the unblock time is reached, then wait to be scheduled again */
+			fiber_yield();
+		}
+	}
+}
+
+/* A running process has used up its share of the quantum, so act on what it decided */
+void handleRunningProcess(PCB *pcb) {
+	pcb->remaining = 0;
+	pcb->decided = false;
+	if (pcb->decision == DECISION_TERMINATED) onProcessTerminated(pcb);
+	else if (pcb->decision == DECISION_EXPIRED) onProcessExpired(pcb);
+	else if (pcb->decision == DECISION_BLOCKED) onProcessBlocked(pcb);
 }
 
-void handleRunningProcess() {
-	if (isProcessRunning()) {
-		/* Since a process running, check what its message */
-		PCB *pcb = global->running;
-		receiveMessage(global->message, getParentQueue(), pcb->actualPID, true);
-		if (strcmp(global->message->text, "TERMINATED") == 0) onProcessTerminated(pcb);
-		else if (strcmp(global->message->text, "EXPIRED") == 0) onProcessExpired(pcb);
-		else if (strcmp(global->message->text, "BLOCKED") == 0) onProcessBlocked(pcb);
+void handleBlockedProcess(PCB *pcb) {
+	if (global->coroutines) {
+		fiber_resume(global->fibers[pcb->localPID]);
+		onProcessUnblocked(pcb);
+		return;
 	}
+	
+	/* The clock has reached the unblock time, so wake the process sleeping on its PCB */
+	__atomic_add_fetch(&pcb->wakeup, 1, __ATOMIC_RELEASE);
+	wakeFutex(&pcb->wakeup);
+	onProcessUnblocked(pcb);
 }
 
-void handleBlockedProcesses() {
-	Queue *blocked = getBlockedQueue();
-	if (!queue_empty(blocked)) {
-		/* Fast-forward into future */
-		if (!isProcessRunning()) {
-			addTime(&global->shared->system, 5e6);
-			addTime(&global->idle, 5e6);
-		}
+void handleExitedProcess(PCB *pcb) {
+	if (global->trace != NULL) {
+		onProcessExited(pcb);
+		return;
+	}
+	
+	if (global->coroutines) {
+		fiber_release(global->fibers[pcb->localPID]);
+		global->fibers[pcb->localPID] = NULL;
+		onProcessExited(pcb);
+		return;
+	}
+	
+	/* The worker has gone back to waiting for its next local PID */
+	if (global->pooled) {
+		global->pool[global->poolSize++] = pcb->actualPID;
+		onProcessExited(pcb);
+		return;
+	}
+	
+	int status;
+	if (waitpid(pcb->actualPID, &status, 0) == -1) crash("waitpid");
+	onProcessExited(pcb);
+}
+
+/* Gives every idle CPU something to run, if there's anything left to run */
+void tryScheduleProcess() {
+	unsigned int i;
+	for (i = 0; i < global->cpuCount; i++) {
+		if (global->cpus[i].running != NULL) continue;
 		
-		/* Check to see if a process is unblocked */
-		int i;
-		for (i = 0; i < blocked->size; i++) {
-			PCB *pcb = getPCB(queue_pop(blocked));
-			if (msgrcv(getParentQueue(), global->message, sizeof(Message), pcb->actualPID, IPC_NOWAIT) > -1 && strcmp(global->message->text, "UNBLOCKED") == 0) {
-				onProcessUnblocked(pcb);
-			} else {
-				queue_push(getBlockedQueue(), pcb->localPID);
-			}
+		/* Real-time processes always run ahead of the scheduling policy */
+		PCB *pcb = edfScheduler.pick_next(i);
+		if (pcb == NULL) pcb = global->scheduler->pick_next(i);
+		if (pcb == NULL) pcb = stealProcess(i);
+		if (pcb != NULL) scheduleProcess(i, pcb);
+	}
+}
+
+/* Nothing but periodic events is left to happen, and no decision is still on its way to bring more */
+bool isSimulationDone() {
+	return global->calendar->size == global->periodic && wheel_empty(global->wheel) && global->inflight == 0;
+}
+
+/* Applies the controller's scale to the default quantum and drop time of every normal queue, which is all a dispatch looks up */
+void adjustQuanta() {
+	if (!controller_update(&global->controller, getNanoseconds(&global->shared->system), global->cpuCount)) return;
+	
+	scaleQuanta(global->controller.scale);
+	logger("Quanta: %.2fx, %d ns at the top normal queue", global->controller.scale, getUserQuantum(1));
+}
+
+/* Makes sure the clock stops when quotas refill, if a process is being held back by one and might have nothing else to wait on */
+void tryRefillGroups() {
+	if (global->scheduler->refill == NULL) return;
+	long time = global->scheduler->refill();
+	if (time == -1 || time == global->refillAt) return;
+	
+	Time refill;
+	setTime(&refill, time);
+	calendar_push(global->calendar, EVENT_REFILL, &refill, 0);
+	global->refillAt = time;
+}
+
+/* Takes a process from the CPU with the most queued, or returns NULL if no other CPU has any */
+PCB *stealProcess(unsigned int cpu) {
+	unsigned int i, busiest = cpu, most = 0;
+	for (i = 0; i < global->cpuCount; i++) {
+		unsigned int load = global->scheduler->load(i);
+		if (i != cpu && load > most) {
+			busiest = i;
+			most = load;
 		}
 	}
+	if (most == 0) return NULL;
+	return global->scheduler->steal(busiest, cpu);
 }
 
-void tryScheduleProcess() {
-	if (isProcessRunning()) return;
+void scheduleProcess(unsigned int cpu, PCB *pcb) {
+	global->cpus[cpu].running = pcb;
+	global->cpus[cpu].dispatches++;
+	if (pcb->processor != cpu) global->cpus[cpu].migrations++;
+	pcb->processor = cpu;
+	copyTime(&global->shared->system, &pcb->dispatched);
+	if (pcb->dispatches++ == 0) pcb->response = subtractTime(&global->shared->system, &pcb->arrival);
+	if (global->controlling) controller_dispatch(&global->controller, pcb->dispatches == 1, getNanoseconds(&pcb->response));
+	onProcessScheduled(pcb);
 	
-	/* Moving from highest priority queue to lowest, if a process exists in it, then run it and return */
-	int i;
-	for (i = 0; i < QUEUE_SET_COUNT; i++) {
-		if (!queue_empty(getActiveSet()[i])) {
-			int localPID = queue_pop(getActiveSet()[i]);
-			PCB *pcb = &global->shared->ptable[localPID];
-			scheduleProcess(pcb);
-			break;
+	/* A preempted process picks up where it left off, since it already decided what to do with its quantum */
+	if (!pcb->decided) {
+		pcb->quantum = getSchedulerClass(pcb)->quantum(pcb);
+		if (global->coroutines) fiber_resume(global->fibers[pcb->localPID]);
+		else if (global->trace != NULL) replayDecision(pcb);
+		else {
+			if (global->rings) ring_send(getDispatchRing(pcb->localPID), OPCODE_DISPATCH, 0);
+			else sendMessage(global->message, getChildQueue(), pcb->actualPID, "", false);
+			
+			/* The intake thread picks the decision up, and the simulation goes on until it can't without it */
+			if (global->pipelined) {
+				global->cpus[cpu].awaiting = true;
+				global->inflight++;
+				return;
+			}
+			receiveDecision(pcb);
 		}
+		pcb->remaining = getDecisionCost(pcb);
+		pcb->decided = true;
 	}
+	
+	startQuantum(pcb);
 }
 
-void trySwapQueueSets() {
-	/* Don't continue if there's a process running */
-	if (isProcessRunning()) return;
+/* Its decision takes effect once the used part of its quantum has elapsed */
+void startQuantum(PCB *pcb) {
+	Time time;
+	copyTime(&pcb->dispatched, &time);
+	addTime(&time, pcb->remaining);
+	calendar_push(global->calendar, EVENT_QUANTUM, &time, pcb->localPID);
+}
+
+/* Takes a CPU the process could run on from a weaker running process, unless one of those CPUs is idle anyway */
+void tryPreemptProcess(PCB *pcb) {
+	/* A class with a queue per CPU can only run the process on the CPU it's queued on */
+	bool shared = getSchedulerClass(pcb)->steal == NULL;
 	
-	/* Don't continue if there's a process in the active runqueues */
-	int i;
-	for (i = 0; i < QUEUE_SET_COUNT; i++) {
-		if (!queue_empty(getActiveSet()[i])) return;
+	int victim = -1;
+	unsigned int i;
+	for (i = 0; i < global->cpuCount; i++) {
+		if (!shared && i != pcb->processor) continue;
+		PCB *running = global->cpus[i].running;
+		if (running == NULL) return;
+		if (!shouldPreempt(pcb, running)) continue;
+		
+		/* Take the CPU from the weakest of the processes it could preempt */
+		if (victim == -1 || shouldPreempt(global->cpus[victim].running, running)) victim = i;
+	}
+	
+	if (victim != -1) preemptProcess(victim);
+}
+
+/* Takes the CPU's process off before its decision takes effect, charging it for the time it did run */
+void preemptProcess(unsigned int cpu) {
+	if (global->cpus[cpu].awaiting) awaitDecision(cpu);
+	PCB *pcb = global->cpus[cpu].running;
+	
+	/* Its quantum ends at this very time, whatever sorted ahead of it, so let that hand the CPU over instead */
+	int time = getRunTime(pcb);
+	if (time >= pcb->remaining) return;
+	
+	calendar_remove(global->calendar, pcb->localPID);
+	
+	pcb->remaining -= time;
+	
+	addTime(&pcb->cpu, time);
+	addTime(&pcb->queue, time);
+	
+	getSchedulerClass(pcb)->on_preempt(pcb, time);
+	
+	global->cpus[cpu].preemptions++;
+	global->cpus[cpu].running = NULL;
+	
+	logger("%-6s PID: %2d, Priority: %d, Preempted", "--*---", pcb->localPID, pcb->priority);
+}
+
+void receiveDecision(PCB *pcb) {
+	/* A ring record carries the decision and the percent used together */
+	if (global->rings) {
+		Record record;
+		ring_receive(getDecisionRing(pcb->localPID), &record);
+		if (record.opcode == OPCODE_TERMINATED) pcb->decision = DECISION_TERMINATED;
+		else if (record.opcode == OPCODE_EXPIRED) pcb->decision = DECISION_EXPIRED;
+		else if (record.opcode == OPCODE_BLOCKED) pcb->decision = DECISION_BLOCKED;
+		pcb->percent = record.percent;
+		return;
 	}
 	
-	/* Don't continue if there's no process in the expired runqueues */
-	bool flag = false;
-	for (i = 0; i < QUEUE_SET_COUNT; i++) {
-		if (!queue_empty(getExpiredSet()[i])) flag = true;
+	receiveMessage(global->message, getParentQueue(), pcb->actualPID, true);
+	if (strcmp(global->message->text, "TERMINATED") == 0) pcb->decision = DECISION_TERMINATED;
+	else if (strcmp(global->message->text, "EXPIRED") == 0) pcb->decision = DECISION_EXPIRED;
+	else if (strcmp(global->message->text, "BLOCKED") == 0) pcb->decision = DECISION_BLOCKED;
+	
+	/* An expired process used its entire quantum, otherwise it says how much it used */
+	if (pcb->decision == DECISION_EXPIRED) pcb->percent = 100;
+	else {
+		receiveMessage(global->message, getParentQueue(), pcb->actualPID, true);
+		pcb->percent = atoi(global->message->text);
 	}
-	if (!flag) return;
+}
+
+/* Takes a decision off the intake queue and starts the quantum of the process it's for, returning whether there was one */
+bool takeDecision(bool wait) {
+	Intake intake;
+	if (!intake_receive(global->intake, &intake, wait)) return false;
 	
-	swapRunSets();
+	/* Only a process dispatched on a CPU can have a decision on its way, so there are at most a few to look through */
+	unsigned int i;
+	for (i = 0; i < global->cpuCount; i++) {
+		PCB *pcb = global->cpus[i].running;
+		if (!global->cpus[i].awaiting || pcb->actualPID != intake.pid) continue;
+		
+		pcb->decision = intake.decision;
+		pcb->percent = intake.percent;
+		pcb->remaining = getDecisionCost(pcb);
+		pcb->decided = true;
+		global->cpus[i].awaiting = false;
+		global->inflight--;
+		startQuantum(pcb);
+		break;
+	}
+	return true;
 }
 
-void scheduleProcess(PCB *pcb) {
-	global->running = pcb;
-	sendMessage(global->message, getChildQueue(), pcb->actualPID, "", false);
-	onProcessScheduled(pcb);
+/*
+ * Takes in every decision that has arrived, then waits for more until the next event is sure to come before the
+ * quantum of any process still waiting on its decision could end. Events before then, like spawns, unblocks and
+ * other CPUs' quanta, go on while decisions are in flight.
+ */
+void awaitDecisions() {
+	while (true) {
+		while (takeDecision(false));
+		if (global->inflight == 0) return;
+		
+		unsigned long expiry;
+		bool timer = wheel_next(global->wheel, &expiry);
+		Event *next = calendar_peek(global->calendar);
+		long time = next != NULL ? getNanoseconds(&next->time) : -1;
+		if (timer && (time == -1 || (long) expiry < time)) time = expiry;
+		if (time != -1 && time < getHorizon()) return;
+		
+		takeDecision(true);
+	}
+}
+
+/* Waits until the decision of the process on the CPU comes in, since it can't be preempted without knowing it */
+void awaitDecision(unsigned int cpu) {
+	while (global->cpus[cpu].awaiting) takeDecision(true);
+}
+
+/* Earliest time a quantum of a process waiting on its decision could end, which is after using 1 percent of it */
+long getHorizon() {
+	long horizon = LONG_MAX;
+	unsigned int i;
+	for (i = 0; i < global->cpuCount; i++) {
+		if (!global->cpus[i].awaiting) continue;
+		PCB *pcb = global->cpus[i].running;
+		long end = getNanoseconds(&pcb->dispatched) + (int) ((double) pcb->quantum * ((double) 1 / (double) 100));
+		if (end < horizon) horizon = end;
+	}
+	return horizon;
+}
+
+/* A replayed job runs until it has had all the CPU it had in the log, and never blocks since the log doesn't say when */
+void replayDecision(PCB *pcb) {
+	if (pcb->demand > pcb->quantum) {
+		pcb->demand -= pcb->quantum;
+		pcb->decision = DECISION_EXPIRED;
+		pcb->percent = 100;
+		return;
+	}
+	
+	/* Rounded up, so a job never gets less CPU than it asked for */
+	pcb->decision = DECISION_TERMINATED;
+	pcb->percent = MAX(1, (int) ((pcb->demand * 100 + pcb->quantum - 1) / pcb->quantum));
+	pcb->demand = 0;
+}
+
+/* Nanoseconds of simulated time for seconds of the log */
+long getTraceTime(long seconds) {
+	return seconds * global->traceScale * 1000;
+}
+
+int getDecisionCost(PCB *pcb) {
+	return (int) ((double) pcb->quantum * ((double) pcb->percent / (double) 100));
+}
+
+/* Time the process has been on its CPU since it was last dispatched */
+int getRunTime(PCB *pcb) {
+	return getNanoseconds(&global->shared->system) - getNanoseconds(&pcb->dispatched);
+}
+
+/* Copies the counters onto the stats page, which only costs OSS a couple of stores to the sequence */
+void publishStats() {
+	Stats *stats = getStatsMemory();
+	beginStatsWrite();
+	
+	copyTime(&global->shared->system, &stats->clock);
+	stats->spawned = global->spawnedProcessCount;
+	stats->exited = global->exitedProcessCount;
+	stats->running = stats->dispatches = stats->preemptions = 0;
+	unsigned int i;
+	for (i = 0; i < global->cpuCount; i++) {
+		if (global->cpus[i].running != NULL) stats->running++;
+		stats->dispatches += global->cpus[i].dispatches;
+		stats->preemptions += global->cpus[i].preemptions;
+	}
+	for (i = 0; i < QUEUE_SET_COUNT; i++)
+		stats->depths[i] = edfScheduler.depth(i) + global->scheduler->depth(i);
+	
+	endStatsWrite();
+}
+
+/* Records the window since the last sample as the difference between running totals, so nothing is counted per event */
+void takeSample() {
+	Sample now = { .time = getNanoseconds(&global->shared->system) };
+	if (global->sampleCount > 0 && now.time == global->totals.time) return;
+	
+	now.completions = global->exitedProcessCount;
+	now.idle = getNanoseconds(&global->idle);
+	unsigned int i;
+	for (i = 0; i < global->cpuCount; i++) {
+		now.dispatches += global->cpus[i].dispatches;
+		now.busy += now.time - getNanoseconds(&global->cpus[i].idle);
+	}
+	
+	Sample *sample = &global->samples[global->sampleCount++ % SAMPLES_MAX];
+	sample->time = now.time;
+	sample->window = now.time - global->totals.time;
+	sample->completions = now.completions - global->totals.completions;
+	sample->dispatches = now.dispatches - global->totals.dispatches;
+	sample->idle = now.idle - global->totals.idle;
+	sample->busy = now.busy - global->totals.busy;
+	for (i = 0; i < QUEUE_SET_COUNT; i++)
+		sample->depths[i] = edfScheduler.depth(i) + global->scheduler->depth(i);
+	sample->quantum = getUserQuantum(1);
+	
+	global->totals = now;
+}
+
+void writeSamples() {
+	FILE *fp;
+	if ((fp = fopen(PATH_SAMPLES, "w")) == NULL) crash("fopen");
+	
+	fprintf(fp, "time,completions,dispatches,idle,utilization,quantum");
+	unsigned int i, j;
+	for (i = 0; i < QUEUE_SET_COUNT; i++) fprintf(fp, ",depth%u", i);
+	fprintf(fp, "\n");
+	
+	/* Oldest first, starting past whatever was overwritten */
+	unsigned int first = global->sampleCount > SAMPLES_MAX ? global->sampleCount - SAMPLES_MAX : 0;
+	for (i = first; i < global->sampleCount; i++) {
+		Sample *sample = &global->samples[i % SAMPLES_MAX];
+		long capacity = sample->window * global->cpuCount;
+		fprintf(fp, "%ld,%u,%u,%ld,%.4f,%d", sample->time, sample->completions, sample->dispatches, sample->idle, capacity > 0 ? (double) sample->busy / capacity : 0, sample->quantum);
+		for (j = 0; j < QUEUE_SET_COUNT; j++) fprintf(fp, ",%u", sample->depths[j]);
+		fprintf(fp, "\n");
+	}
+	
+	if (fclose(fp) == EOF) crash("fclose");
 }
 
 void cleanupResources(bool forced) {
+	if (global->intake != NULL && !forced) intake_stop(global->intake);
+	if (global->trace != NULL) trace_close(global->trace);
+	releaseStatsMemory();
 	releaseSharedMemory();
 	releaseMessageQueues();
 	free(global);
@@ -348,10 +1450,13 @@ void handleSignal(int signal) {
 	else if (signal == SIGINT) {
 		/* Kill all still-running child processes */
 		int i;
-		for (i = 0; i < PROCESSES_CONCURRENT_MAX; i++) {
+		for (i = 1; i <= global->concurrency; i++) {
 			PCB *pcb = &global->shared->ptable[i];
-			if (pcb->localPID != 0) kill(pcb->actualPID, SIGTERM);
+			if (pcb->localPID != 0 && pcb->actualPID > 0) kill(pcb->actualPID, SIGTERM);
 		}
+		if (global->workers != NULL)
+			for (i = 0; i < global->concurrency; i++)
+				if (global->workers[i] > 0) kill(global->workers[i], SIGTERM);
 		while (wait(NULL) > 0);
 		
 		cleanupResources(true);
@@ -362,15 +1467,19 @@ void handleSignal(int signal) {
 void onProcessCreated(PCB *pcb) {
 	global->spawnedProcessCount++;
 	
-	queue_push(getActiveSet()[pcb->priority], pcb->localPID);
+	pcb->processor = getIdlestCPU();
+	getSchedulerClass(pcb)->enqueue(pcb);
 	
-	global->nextSpawnAttempt.sec = global->shared->system.sec;
-	global->nextSpawnAttempt.ns = global->shared->system.ns;
-	int addsec = abs(rand() * rand()) % (MAX_TIME_BETWEEN_NEW_PROCS_SEC + 1);
-	int addns = abs(rand() * rand()) % (MAX_TIME_BETWEEN_NEW_PROCS_NS + 1);
-	addTime(&global->nextSpawnAttempt, addsec * 1e9 + addns);
+	copyTime(&global->shared->system, &global->lastSpawn);
+	if (global->trace != NULL) {
+		global->jobPending = trace_next(global->trace, &global->job);
+		if (global->jobPending) setTime(&global->nextSpawnAttempt, getTraceTime(global->job.submit - global->traceStart));
+	} else setTime(&global->nextSpawnAttempt, arrival_next(&global->arrival, getNanoseconds(&global->shared->system)));
+	if (global->spawnedProcessCount < global->processTotal && (global->trace == NULL || global->jobPending)) calendar_push(global->calendar, EVENT_SPAWN, &global->nextSpawnAttempt, 0);
 	
 	logger("%-6s PID: %2d, Priority: %d", "*-----", pcb->localPID, pcb->priority);
+	
+	tryPreemptProcess(pcb);
 }
 
 void onProcessScheduled(PCB *pcb) {
@@ -378,24 +1487,33 @@ void onProcessScheduled(PCB *pcb) {
 }
 
 void onProcessTerminated(PCB *pcb) {
-	receiveMessage(global->message, getParentQueue(), pcb->actualPID, true);
-	
 	copyTime(&global->shared->system, &pcb->exit);
 	
-	int percent = atoi(global->message->text);
-	int cost = getUserQuantum(pcb->priority);
-	int time = (int) ((double) cost * ((double) percent / (double) 100));
+	int time = getRunTime(pcb);
 	
 	addTime(&pcb->cpu, time);
 	addTime(&pcb->queue, time);
-	addTime(&global->shared->system, time);
 	
-	subTime(&pcb->wait, &pcb->cpu);
-	subTime(&pcb->wait, &pcb->block);
+	/* Whatever part of its time in the system it wasn't running or blocked, it was waiting */
+	long wait = getNanoseconds(&pcb->exit) - getNanoseconds(&pcb->arrival) - getNanoseconds(&pcb->cpu) - getNanoseconds(&pcb->block);
+	setTime(&pcb->wait, wait > 0 ? wait : 0);
+	
+	getSchedulerClass(pcb)->on_exit(pcb, time);
+	
+	global->cpus[pcb->processor].running = NULL;
 	
-	global->running = NULL;
+	/* Reap the actual process now that it has exited */
+	calendar_push(global->calendar, EVENT_EXIT, &global->shared->system, pcb->localPID);
+	
+	Histogram **latencies = global->latencies[isProcessRealtime(pcb) ? CLASS_REALTIME : CLASS_NORMAL];
+	histogram_record(latencies[METRIC_WAIT], getNanoseconds(&pcb->wait));
+	histogram_record(latencies[METRIC_BLOCK], getNanoseconds(&pcb->block));
+	histogram_record(latencies[METRIC_CPU], getNanoseconds(&pcb->cpu));
+	histogram_record(latencies[METRIC_TURNAROUND], getNanoseconds(&pcb->exit) - getNanoseconds(&pcb->arrival));
+	histogram_record(latencies[METRIC_RESPONSE], getNanoseconds(&pcb->response));
 	
 	logger("%-6s PID: %2d, Priority: %d", "-----*", pcb->localPID, pcb->priority);
+	if (!global->verbose) return;
 	printf("\nPROCESS TERMINATED\n");
 	printf("\tActual PID: %d\n", pcb->actualPID);
 	printf("\tLocal PID:  %d\n", pcb->localPID);
@@ -409,127 +1527,218 @@ void onProcessTerminated(PCB *pcb) {
 
 void onProcessExpired(PCB *pcb) {
 	int previousPriority = pcb->priority;
-	int nextPriority = pcb->priority;
 	
-	int percent = 100;
-	int cost = getUserQuantum(pcb->priority);
-	int time = (int) ((double) cost * ((double) percent / (double) 100));
+	int time = getRunTime(pcb);
 	
 	addTime(&pcb->cpu, time);
 	addTime(&pcb->queue, time);
-	addTime(&global->shared->system, time);
-	
-	if (pcb->priority == 0) { /* Process is real-time */
-		queue_push(getActiveSet()[nextPriority], pcb->localPID);
-		logger("%-6s PID: %2d, Priority: %d", "--*---", pcb->localPID, pcb->priority);
-	} else { /* Process is normal */
-		/* Determine if this process can shift priority */
-		int n = getQueueQuantum(pcb->priority);
-		if (n != -1 && pcb->queue.ns >= n) {
-			nextPriority++;
-			if (nextPriority > QUEUE_SET_COUNT - 1) nextPriority = QUEUE_SET_COUNT - 1;
-			pcb->priority = nextPriority;
-			clearTime(&pcb->queue);
-			logger("%-6s PID: %2d, Priority: %d <- %d", "--*---", pcb->localPID, nextPriority, previousPriority);
-		} else {
-			logger("%-6s PID: %2d, Priority: %d", "--*---", pcb->localPID, pcb->priority);
-		}
-		
-		queue_push(getExpiredSet()[nextPriority], pcb->localPID);
-	}
 	
-	global->running = NULL;
+	/* The policy requeues it, and may shift its priority */
+	getSchedulerClass(pcb)->on_tick(pcb, time);
+	
+	if (pcb->priority != previousPriority) logger("%-6s PID: %2d, Priority: %d <- %d", "--*---", pcb->localPID, pcb->priority, previousPriority);
+	else logger("%-6s PID: %2d, Priority: %d", "--*---", pcb->localPID, pcb->priority);
+	
+	global->cpus[pcb->processor].running = NULL;
 }
 
 void onProcessBlocked(PCB *pcb) {
-	receiveMessage(global->message, getParentQueue(), pcb->actualPID, true);
-	
-	int percent = atoi(global->message->text);
-	int cost = getUserQuantum(pcb->priority);
-	int time = (int) ((double) cost * ((double) percent / (double) 100));
+	int time = getRunTime(pcb);
 	
 	addTime(&pcb->cpu, time);
 	addTime(&pcb->queue, time);
-	addTime(&global->shared->system, time);
 	
-	logger("%-6s PID: %2d, Priority: %d", "---*--", pcb->localPID, pcb->priority);
-	queue_push(getBlockedQueue(), pcb->localPID);
-	global->running = NULL;
+	getSchedulerClass(pcb)->on_block(pcb, time);
+	
+	if (global->diskCount > 0) submitRequest(pcb);
+	else {
+		/* Blocked from now rather than from its decision, since a preempted process waited on a CPU in between */
+		copyTime(&global->shared->system, &pcb->unblock);
+		addTime(&pcb->unblock, pcb->blocked);
+		addTime(&pcb->block, pcb->blocked);
+		
+		WheelTimer *timer = &global->timers[pcb->localPID];
+		timer->localPID = pcb->localPID;
+		wheel_add(global->wheel, timer, getNanoseconds(&pcb->unblock));
+		logger("%-6s PID: %2d, Priority: %d", "---*--", pcb->localPID, pcb->priority);
+	}
+	
+	global->cpus[pcb->processor].running = NULL;
 }
 
 void onProcessUnblocked(PCB *pcb) {
-	queue_push(getActiveSet()[pcb->priority], pcb->localPID);
+	getSchedulerClass(pcb)->on_unblock(pcb);
 	logger("%-6s PID: %2d, Priority: %d", "----*-", pcb->localPID, pcb->priority);
+	
+	tryPreemptProcess(pcb);
 }
 
-void onProcessExited(PCB *pcb) {
-	global->exitedProcessCount++;
+/* Takes a disk policy, optionally followed by how many disks there are */
+bool setDisks(char *spec) {
+	char name[BUFFER_LENGTH];
+	strncpy(name, spec, BUFFER_LENGTH - 1);
+	name[BUFFER_LENGTH - 1] = '\0';
 	
-	addTime(&global->totalCpu, pcb->cpu.sec * 1e9 + pcb->cpu.ns);
-	addTime(&global->totalBlock, pcb->block.sec * 1e9 + pcb->block.ns);
-	addTime(&global->totalWait, pcb->wait.sec * 1e9 + pcb->wait.ns);
+	int count = 1;
+	char *colon = strchr(name, ':');
+	if (colon != NULL) {
+		*colon = '\0';
+		count = atoi(colon + 1);
+	}
 	
-	releasePCB(pcb);
+	int policy = disk_policy(name);
+	if (policy == -1 || count < 1 || count > DISKS_MAX) return false;
+	global->diskPolicy = policy;
+	global->diskCount = count;
+	return true;
 }
 
-/* Returns an index of the bit vector that is 0 */
-int findAvailableLocalPID() {
-	unsigned int i = 1, pos = 1;
+/* A blocked process waits on an I/O request to a random cylinder of a random disk */
+void submitRequest(PCB *pcb) {
+	DiskRequest *request = &global->requests[pcb->localPID];
+	request->localPID = pcb->localPID;
+	request->disk = rand() % global->diskCount;
+	request->cylinder = rand() % DISK_CYLINDERS;
+	request->submit = getNanoseconds(&global->shared->system);
 	
-	while ((i & global->vector) && pos <= PROCESSES_CONCURRENT_MAX) {
-		i <<= 1;
-		pos++;
-	}
+	Disk *disk = &global->disks[request->disk];
+	disk_submit(disk, request);
+	logger("%-6s PID: %2d, Priority: %d, Disk: %u, Cylinder: %u", "---*--", pcb->localPID, pcb->priority, request->disk, request->cylinder);
 	
-	return pos <= PROCESSES_CONCURRENT_MAX ? pos : -1;
+	startRequest(disk);
 }
 
-PCB *getPCB(unsigned int localPID) {
-	return &global->shared->ptable[localPID];
+/* Starts the disk on its next request if it's idle, with the event keyed by the local PID of the process waiting on it */
+void startRequest(Disk *disk) {
+	long service;
+	DiskRequest *request = disk_start(disk, &service);
+	if (request == NULL) return;
+	
+	Time time;
+	copyTime(&global->shared->system, &time);
+	addTime(&time, service);
+	calendar_push(global->calendar, EVENT_IO, &time, request->localPID);
 }
 
-bool isProcessRunning() {
-	return global->running != NULL;
+void handleRequest(PCB *pcb) {
+	DiskRequest *request = &global->requests[pcb->localPID];
+	Disk *disk = &global->disks[request->disk];
+	disk_finish(disk);
+	
+	/* Blocked for as long as the request was queued and served */
+	long duration = getNanoseconds(&global->shared->system) - request->submit;
+	addTime(&pcb->block, duration);
+	histogram_record(global->ioLatencies, duration);
+	
+	handleBlockedProcess(pcb);
+	startRequest(disk);
 }
 
-bool isProcessRealtime(PCB *pcb) {
-	return pcb->priority == 0;
+void printDisks(long system) {
+	static double percentiles[] = { 50, 90, 99, 99.9 };
+	
+	printf("DISKS\n");
+	printf("\tPolicy: %s\n", disk_policy_name(global->diskPolicy));
+	unsigned int i;
+	for (i = 0; i < global->diskCount; i++) {
+		Disk *disk = &global->disks[i];
+		double utilization = system > 0 ? 100.0 * disk->busy / system : 0;
+		double seek = disk->served > 0 ? (double) disk->distance / disk->served : 0;
+		printf("\t%2u: Utilization: %5.1f%%, Requests: %lu, Cylinders per request: %.0f\n", i, utilization, disk->served, seek);
+	}
+	
+	if (global->ioLatencies->total == 0) return;
+	printf("\t%-11s %-14s %-14s %-14s %s\n", "", "p50", "p90", "p99", "p99.9");
+	printf("\t%-11s", "I/O:");
+	for (i = 0; i < 4; i++) {
+		Time time;
+		char buf[BUFFER_LENGTH];
+		setTime(&time, histogram_percentile(global->ioLatencies, percentiles[i]));
+		snprintf(buf, BUFFER_LENGTH, "%ld:%ld", time.sec, time.ns);
+		printf(i < 3 ? " %-14s" : " %s", buf);
+	}
+	printf("\n");
 }
 
-void initializeQueues() {
-	int i;
-	for (i = 0; i < QUEUE_SET_COUNT; i++) {
-		global->qset1[i] = queue_create(QUEUE_SET_SIZE);
-		global->qset2[i] = queue_create(QUEUE_SET_SIZE);
+void printGroups(long system) {
+	unsigned int i, count = getGroupCount();
+	long total = 0;
+	for (i = 0; i < count; i++) total += getGroupStats(i)->cpu;
+	
+	printf("GROUPS\n");
+	for (i = 0; i < count; i++) {
+		GroupStats *group = getGroupStats(i);
+		char quota[BUFFER_LENGTH];
+		if (group->quota > 0) snprintf(quota, BUFFER_LENGTH, "%.0f%%", 100.0 * group->quota / GROUP_PERIOD);
+		else snprintf(quota, BUFFER_LENGTH, "none");
+		
+		/* Utilization is in percent of one CPU, the same as the quota */
+		double utilization = system > 0 ? 100.0 * group->cpu / system : 0;
+		double share = total > 0 ? 100.0 * group->cpu / total : 0;
+		Time turnaround;
+		setTime(&turnaround, group->exited > 0 ? group->turnaround / group->exited : 0);
+		printf("\t%2u: Weight: %u, Quota: %s, Processes: %u, Utilization: %5.1f%%, Share: %5.1f%%, Throttled: %u periods, Turnaround: %ld:%ld\n", i, group->weight, quota, group->processes, utilization, share, group->throttles, turnaround.sec, turnaround.ns);
 	}
+}
+
+void onProcessExited(PCB *pcb) {
+	global->exitedProcessCount++;
+	
+	addTime(&global->totalCpu, pcb->cpu.sec * 1e9 + pcb->cpu.ns);
+	addTime(&global->totalBlock, pcb->block.sec * 1e9 + pcb->block.ns);
+	addTime(&global->totalWait, pcb->wait.sec * 1e9 + pcb->wait.ns);
+	
+	releasePCB(pcb);
 	
-	global->active = global->qset1;
-	global->expired = global->qset2;
-	global->blocked = queue_create(QUEUE_BLOCK_SIZE);
+	/* A spawn was put off because every PID was taken, so retry it now that one is free */
+	if (global->spawnDeferred) {
+		global->spawnDeferred = false;
+		calendar_push(global->calendar, EVENT_SPAWN, &global->shared->system, 0);
+	}
 }
 
-void swapRunSets() {
-	Queue **temp = global->active;
-	global->active = global->expired;
-	global->expired = temp;
+/* Takes the lowest free local PID, or returns -1 if every one is in use */
+int findAvailableLocalPID() {
+	int id = pidmap_allocate(global->pids);
+	return id == -1 ? -1 : id + 1;
 }
 
-Queue **getActiveSet() {
-	return global->active;
+PCB *getPCB(unsigned int localPID) {
+	return &global->shared->ptable[localPID];
 }
 
-void setActiveSet(Queue **set) {
-	global->active = set;
+/* Returns the CPU with the least work queued or running, for placing a new process */
+unsigned int getIdlestCPU() {
+	unsigned int i, idlest = 0, least = -1;
+	for (i = 0; i < global->cpuCount; i++) {
+		unsigned int load = global->scheduler->load(i) + (global->cpus[i].running != NULL);
+		if (load < least) {
+			idlest = i;
+			least = load;
+		}
+	}
+	return idlest;
 }
 
-Queue **getExpiredSet() {
-	return global->expired;
+/* Whether the runnable process should take the CPU from the running one, where real-time always wins */
+bool shouldPreempt(PCB *pcb, PCB *running) {
+	SchedulerOps *class = getSchedulerClass(pcb);
+	if (class != getSchedulerClass(running)) return isProcessRealtime(pcb);
+	return class->preempts != NULL && class->preempts(pcb, running);
 }
 
-void setExpiredSet(Queue **set) {
-	global->expired = set;
+/* Whether any CPU is running a process */
+bool isProcessRunning() {
+	unsigned int i;
+	for (i = 0; i < global->cpuCount; i++)
+		if (global->cpus[i].running != NULL) return true;
+	return false;
+}
+
+bool isProcessRealtime(PCB *pcb) {
+	return pcb->priority == 0;
 }
 
-Queue *getBlockedQueue() {
-	return global->blocked;
+SchedulerOps *getSchedulerClass(PCB *pcb) {
+	return isProcessRealtime(pcb) ? &edfScheduler : global->scheduler;
 }
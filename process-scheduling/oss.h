@@ -18,12 +18,26 @@
 #define BIT_FLIP(a, b) ((a) ^= (1ULL << (b)))
 #define BIT_CHECK(a, b) (!!((a) & (1ULL << (b))))
 
-#define MAX_TIME_BETWEEN_NEW_PROCS_SEC 1
-#define MAX_TIME_BETWEEN_NEW_PROCS_NS 15000
-
 #define CHANCE_PROCESS_REALTIME 5
 
-typedef unsigned long int bv_t; /* Type-defined bit-vector */
+#define CALENDAR_SIZE (PROCESSES_CONCURRENT_MAX * 2)
+
+#define CPUS_MAX 64
+
+#define STATS_EVENTS 64 /* Events between updates of the stats page */
+
+#define SAMPLES_MAX 4096 /* Oldest samples are overwritten past this */
+#define PATH_SAMPLES "./samples.csv"
+
+#define TRACE_SCALE 1000 /* Simulated microseconds per second of a replayed log */
+#define BATCH_PROCESSORS_MAX 1000000
+#define SLOWDOWN_THRESHOLD 10 /* Seconds of the log a shorter job's run time counts as for bounded slowdown */
+
+enum EventType { EVENT_SPAWN, EVENT_QUANTUM, EVENT_UNBLOCK, EVENT_EXIT, EVENT_SAMPLE, EVENT_IO, EVENT_REFILL, EVENT_CONTROL };
+
+/* Latency histograms are kept per class and per metric */
+enum ClassType { CLASS_REALTIME, CLASS_NORMAL, CLASS_COUNT };
+enum MetricType { METRIC_WAIT, METRIC_BLOCK, METRIC_CPU, METRIC_TURNAROUND, METRIC_RESPONSE, METRIC_COUNT };
 
 void usage(int status) {
 	if (status != EXIT_SUCCESS) fprintf(stderr, "Try '%s -h' for more information\n", getProgramName());
@@ -31,9 +45,31 @@ void usage(int status) {
 		printf("NAME\n");
 		printf("       %s - OS process-scheduling simulator\n", getProgramName());
 		printf("USAGE\n");
-		printf("       %s [-h]\n", getProgramName());
+		printf("       %s [-h] [-c | -w] [-j] [-r] [-v] [-a x | -f x] [-b x] [-d x] [-e x] [-i x] [-m x] [-n x] [-o x] [-p x | -g x] [-q x | -u x] [-s x] [-t x] [-x x]\n", getProgramName());
 		printf("DESCRIPTION\n");
 		printf("       -h       : Prints usage information and exits\n");
+		printf("       -c       : Runs user processes as coroutines inside OSS instead of forking them\n");
+		printf("       -w       : Pre-forks a pool of user processes that are reused for every simulated process\n");
+		printf("       -j       : Receives decisions on a separate thread, so the simulation goes on while they're in flight\n");
+		printf("       -r       : Exchanges dispatches and decisions over shared-memory rings instead of message queues\n");
+		printf("       -v       : Prints every terminated process and echoes the log to the console\n");
+		printf("       -a x     : Arrival process, uniform, poisson:r, fixed:r, mmpp:r,r,t,t, onoff:r,t,t or diurnal:r,a,t (default uniform)\n");
+		printf("       -f x     : Replays the jobs of a Standard Workload Format log without forking or messaging\n");
+		printf("       -b x     : Runs the jobs replayed with -f on a batch partition of x processors with EASY backfilling\n");
+		printf("       -d x     : Blocked processes wait on simulated disks, fcfs, sstf, scan or clook, optionally followed by :n disks\n");
+		printf("       -e x     : Seeds the simulation and every user process with x, so a run can be repeated\n");
+		printf("       -i x     : Samples throughput and run queue depth every x milliseconds of simulated time into %s\n", PATH_SAMPLES);
+		printf("       -m x     : Simulated CPUs, each with its own run queues (default 1)\n");
+		printf("       -n x     : Total processes to spawn (default %d, or every job with -f)\n", PROCESSES_TOTAL_MAX);
+		printf("       -o x     : Writes the figures of the summary to x as name,value lines\n");
+		printf("       -p x     : Scheduling policy, mlfq or cfs (default mlfq)\n");
+		printf("       -g x     : Shares the CPUs between groups of processes, given as weight[:quota] for each group, separated by commas\n");
+		printf("       -q x     : Adjusts the quanta of normal queues to a mean response time of x milliseconds, optionally followed by\n");
+		printf("                  :s for the most dispatches per second on each CPU and :min:max for how far they can be scaled\n");
+		printf("       -s x     : Most processes in the system at once (default %d)\n", PROCESSES_CONCURRENT_MAX);
+		printf("       -t x     : Seconds before no more processes are spawned (default %d, or none with -f)\n", TIMEOUT);
+		printf("       -u x     : Quantum of the top normal queue in milliseconds, with the others keeping their ratios to it (default %g)\n", getDefaultQuantum(1) / 1e6);
+		printf("       -x x     : Simulated microseconds per second of the log replayed with -f (default %d)\n", TRACE_SCALE);
 	}
 	exit(status);
 }
@@ -0,0 +1,141 @@
+/*
+ * ossstat.c 11/9/20
+ * Jared Diehl (jmddnb@umsystem.edu)
+ */
+
+#include <dirent.h>
+#include <errno.h>
+#include <getopt.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "shared.h"
+
+/*
+ * Samples the stats page of a running OSS, like vmstat. Counters show how much they went up since the line before,
+ * while the clock, running CPUs and queue depths are shown as they are.
+ */
+
+void usage(int);
+pid_t findOSS();
+void printHeader();
+void printLine(Stats*, Stats*);
+
+int main(int argc, char **argv) {
+	init(argc, argv);
+	
+	pid_t pid = 0;
+	
+	while (true) {
+		int c = getopt(argc, argv, "hp:");
+		if (c == -1) break;
+		switch (c) {
+			case 'h':
+				usage(EXIT_SUCCESS);
+			case 'p':
+				if ((pid = atoi(optarg)) < 1) {
+					error("invalid PID '%s'", optarg);
+					usage(EXIT_FAILURE);
+				}
+				break;
+			default:
+				usage(EXIT_FAILURE);
+		}
+	}
+	
+	int interval = 1, count = 0;
+	if (optind < argc && (interval = atoi(argv[optind++])) < 1) {
+		error("invalid interval '%s'", argv[optind - 1]);
+		usage(EXIT_FAILURE);
+	}
+	if (optind < argc && (count = atoi(argv[optind++])) < 1) {
+		error("invalid count '%s'", argv[optind - 1]);
+		usage(EXIT_FAILURE);
+	}
+	
+	allocateStatsMemory(pid > 0 ? pid : findOSS());
+	if (getStatsMemory()->version != STATS_VERSION) {
+		error("stats page is version %u, expected %u", getStatsMemory()->version, STATS_VERSION);
+		exit(EXIT_FAILURE);
+	}
+	
+	/* The first line counts everything since the simulation started */
+	Stats previous, current;
+	memset(&previous, 0, sizeof(Stats));
+	
+	printHeader();
+	int i;
+	for (i = 0; count == 0 || i < count; i++) {
+		if (i > 0) sleep(interval);
+		readStats(&current);
+		printLine(&previous, &current);
+		previous = current;
+		if (current.finished) break;
+	}
+	
+	releaseStatsMemory();
+	return EXIT_SUCCESS;
+}
+
+void usage(int status) {
+	if (status != EXIT_SUCCESS) fprintf(stderr, "Try '%s -h' for more information\n", getProgramName());
+	else {
+		printf("NAME\n");
+		printf("       %s - OS process-scheduling simulator statistics\n", getProgramName());
+		printf("USAGE\n");
+		printf("       %s [-h] [-p x] [interval [count]]\n", getProgramName());
+		printf("DESCRIPTION\n");
+		printf("       -h       : Prints usage information and exits\n");
+		printf("       -p x     : PID of the OSS to watch (default the only one running in this directory)\n");
+		printf("       interval : Seconds between lines (default 1)\n");
+		printf("       count    : Lines before exiting (default until the simulation is over)\n");
+	}
+	exit(status);
+}
+
+/* Picks the only OSS that left a stats page identifier in the working directory and is still running */
+pid_t findOSS() {
+	DIR *dir;
+	if ((dir = opendir(".")) == NULL) crash("opendir");
+	
+	pid_t found = 0;
+	unsigned int count = 0;
+	struct dirent *entry;
+	while ((entry = readdir(dir)) != NULL) {
+		int pid, length = 0;
+		if (sscanf(entry->d_name, PATH_STATS "%n", &pid, &length) != 1 || length == 0 || entry->d_name[length] != '\0') continue;
+		
+		/* An OSS that was killed never got to remove its file */
+		if (kill(pid, 0) == -1 && errno == ESRCH) continue;
+		
+		found = pid;
+		count++;
+	}
+	closedir(dir);
+	
+	if (count == 0) error("no OSS is running in this directory");
+	else if (count > 1) error("%u OSS are running in this directory, pick one with -p", count);
+	if (count != 1) exit(EXIT_FAILURE);
+	return found;
+}
+
+void printHeader() {
+	printf("%-16s %7s %7s %7s %9s %7s", "clock", "spawned", "exited", "running", "dispatch", "preempt");
+	int i;
+	for (i = 0; i < QUEUE_SET_COUNT; i++) printf("      q%d", i);
+	printf("\n");
+}
+
+void printLine(Stats *previous, Stats *current) {
+	char clock[BUFFER_LENGTH];
+	snprintf(clock, BUFFER_LENGTH, "%ld:%ld", current->clock.sec, current->clock.ns);
+	printf("%-16s %7u %7u %7u %9u %7u", clock, current->spawned - previous->spawned, current->exited - previous->exited, current->running, current->dispatches - previous->dispatches, current->preemptions - previous->preemptions);
+	int i;
+	for (i = 0; i < QUEUE_SET_COUNT; i++) printf(" %7u", current->depths[i]);
+	printf("\n");
+}
@@ -0,0 +1,67 @@
+/*
+ * pidmap.c 11/9/20
+ * Jared Diehl (jmddnb@umsystem.edu)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "pidmap.h"
+
+PidMap *pidmap_create(unsigned int size) {
+	PidMap *pidmap = (PidMap*) calloc(1, sizeof(PidMap));
+	pidmap->size = size;
+
+	/* Keep adding levels until a single word covers the one below */
+	unsigned int bits = size;
+	do {
+		unsigned int words = (bits + 63) / 64;
+		unsigned long *bitmap = (unsigned long*) calloc(words, sizeof(unsigned long));
+
+		/* Every ID, and so every word, starts out free */
+		unsigned int i;
+		for (i = 0; i < bits; i++)
+			bitmap[i / 64] |= 1UL << (i % 64);
+
+		pidmap->bitmaps[pidmap->levels++] = bitmap;
+		bits = words;
+	} while (bits > 1);
+
+	return pidmap;
+}
+
+/* Returns the lowest free ID, or -1 if there is none */
+int pidmap_allocate(PidMap *pidmap) {
+	unsigned int level = pidmap->levels - 1;
+	if (pidmap->bitmaps[level][0] == 0) return -1;
+
+	/* Follow the lowest set bit from the top level down to a free ID */
+	unsigned int index = 0;
+	while (true) {
+		index = index * 64 + __builtin_ctzl(pidmap->bitmaps[level][index]);
+		if (level == 0) break;
+		level--;
+	}
+
+	/* Take it, then mark each word above as full if the one below it just filled up */
+	unsigned int id = index;
+	for (level = 0; level < pidmap->levels; level++) {
+		unsigned long *word = &pidmap->bitmaps[level][index / 64];
+		*word &= ~(1UL << (index % 64));
+		if (*word != 0) break;
+		index /= 64;
+	}
+
+	return id;
+}
+
+void pidmap_release(PidMap *pidmap, unsigned int id) {
+	unsigned int level, index = id;
+	for (level = 0; level < pidmap->levels; level++) {
+		unsigned long *word = &pidmap->bitmaps[level][index / 64];
+		bool full = *word == 0;
+		*word |= 1UL << (index % 64);
+		if (!full) break;
+		index /= 64;
+	}
+}
@@ -0,0 +1,28 @@
+/*
+ * pidmap.h 11/9/20
+ * Jared Diehl (jmddnb@umsystem.edu)
+ */
+
+#ifndef PIDMAP_H
+#define PIDMAP_H
+
+#include <stdbool.h>
+
+/* Six levels of 64-bit words are enough for every unsigned int ID */
+#define PIDMAP_LEVELS_MAX 6
+
+/*
+ * Hierarchical free bitmap, where a set bit on the bottom level means the ID is free and a set bit on any level
+ * above means the word below it still has a free ID
+ */
+typedef struct {
+	unsigned int size; /* IDs go from 0 to size - 1 */
+	unsigned int levels;
+	unsigned long *bitmaps[PIDMAP_LEVELS_MAX]; /* Level 0 is the bottom */
+} PidMap;
+
+PidMap *pidmap_create(unsigned int);
+int pidmap_allocate(PidMap*);
+void pidmap_release(PidMap*, unsigned int);
+
+#endif
@@ -0,0 +1,248 @@
+/*
+ * rbtree.c 11/9/20
+ * Jared Diehl (jmddnb@umsystem.edu)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "rbtree.h"
+
+static bool isRed(RBNode *node) {
+	return node != NULL && node->red;
+}
+
+/* Puts child where node was under node's parent */
+static void replace(RBTree *tree, RBNode *node, RBNode *child) {
+	if (node->parent == NULL) tree->root = child;
+	else if (node == node->parent->left) node->parent->left = child;
+	else node->parent->right = child;
+	if (child != NULL) child->parent = node->parent;
+}
+
+/* Recomputes the node and every node above it, after the node's subtree changed */
+static void propagate(RBTree *tree, RBNode *node) {
+	if (tree->update == NULL) return;
+	for (; node != NULL; node = node->parent) tree->update(node);
+}
+
+/* A rotation only changes the subtrees of the two nodes it turns, the lower of which is updated first */
+static void rotateLeft(RBTree *tree, RBNode *node) {
+	RBNode *right = node->right;
+	node->right = right->left;
+	if (right->left != NULL) right->left->parent = node;
+	replace(tree, node, right);
+	right->left = node;
+	node->parent = right;
+	if (tree->update != NULL) {
+		tree->update(node);
+		tree->update(right);
+	}
+}
+
+static void rotateRight(RBTree *tree, RBNode *node) {
+	RBNode *left = node->left;
+	node->left = left->right;
+	if (left->right != NULL) left->right->parent = node;
+	replace(tree, node, left);
+	left->right = node;
+	node->parent = left;
+	if (tree->update != NULL) {
+		tree->update(node);
+		tree->update(left);
+	}
+}
+
+void rbtree_initialize(RBTree *tree, bool (*less)(RBNode*, RBNode*)) {
+	tree->root = tree->leftmost = NULL;
+	tree->less = less;
+	tree->update = NULL;
+	tree->size = 0;
+}
+
+/* Keeps a sum over every node's subtree up to date through inserts, erases and rotations */
+void rbtree_augment(RBTree *tree, void (*update)(RBNode*)) {
+	tree->update = update;
+}
+
+/* Equal nodes go to the right of each other, so they come out in the order they went in */
+void rbtree_insert(RBTree *tree, RBNode *node) {
+	RBNode *parent = NULL, **link = &tree->root;
+	bool leftmost = true;
+
+	while (*link != NULL) {
+		parent = *link;
+		if (tree->less(node, parent)) link = &parent->left;
+		else {
+			link = &parent->right;
+			leftmost = false;
+		}
+	}
+
+	node->parent = parent;
+	node->left = node->right = NULL;
+	node->red = true;
+	*link = node;
+	if (leftmost) tree->leftmost = node;
+	tree->size++;
+	propagate(tree, node);
+
+	/* Fix any red node with a red parent */
+	while (isRed(node->parent)) {
+		RBNode *parent = node->parent, *grandparent = parent->parent;
+		if (parent == grandparent->left) {
+			RBNode *uncle = grandparent->right;
+			if (isRed(uncle)) {
+				parent->red = uncle->red = false;
+				grandparent->red = true;
+				node = grandparent;
+				continue;
+			}
+			if (node == parent->right) {
+				rotateLeft(tree, parent);
+				node = parent;
+				parent = node->parent;
+			}
+			parent->red = false;
+			grandparent->red = true;
+			rotateRight(tree, grandparent);
+		} else {
+			RBNode *uncle = grandparent->left;
+			if (isRed(uncle)) {
+				parent->red = uncle->red = false;
+				grandparent->red = true;
+				node = grandparent;
+				continue;
+			}
+			if (node == parent->left) {
+				rotateRight(tree, parent);
+				node = parent;
+				parent = node->parent;
+			}
+			parent->red = false;
+			grandparent->red = true;
+			rotateLeft(tree, grandparent);
+		}
+	}
+	tree->root->red = false;
+}
+
+void rbtree_erase(RBTree *tree, RBNode *node) {
+	if (tree->leftmost == node) tree->leftmost = rbtree_next(node);
+	tree->size--;
+
+	RBNode *child, *parent;
+	bool red;
+
+	if (node->left == NULL || node->right == NULL) {
+		/* At most one child, which simply takes the node's place */
+		child = node->left != NULL ? node->left : node->right;
+		parent = node->parent;
+		red = node->red;
+		replace(tree, node, child);
+	} else {
+		/* Two children, so the node's successor takes its place */
+		RBNode *successor = node->right;
+		while (successor->left != NULL) successor = successor->left;
+		child = successor->right;
+		red = successor->red;
+
+		if (successor->parent == node) parent = successor;
+		else {
+			parent = successor->parent;
+			replace(tree, successor, child);
+			successor->right = node->right;
+			successor->right->parent = successor;
+		}
+
+		replace(tree, node, successor);
+		successor->left = node->left;
+		successor->left->parent = successor;
+		successor->red = node->red;
+	}
+
+	/* Everything from where a node was taken out up to the root lost it from its subtree */
+	propagate(tree, parent);
+
+	/* Removing a black node leaves one path short a black node, so fix that */
+	if (red) return;
+	while (child != tree->root && !isRed(child)) {
+		if (child == parent->left) {
+			RBNode *sibling = parent->right;
+			if (isRed(sibling)) {
+				sibling->red = false;
+				parent->red = true;
+				rotateLeft(tree, parent);
+				sibling = parent->right;
+			}
+			if (!isRed(sibling->left) && !isRed(sibling->right)) {
+				sibling->red = true;
+				child = parent;
+				parent = child->parent;
+				continue;
+			}
+			if (!isRed(sibling->right)) {
+				sibling->left->red = false;
+				sibling->red = true;
+				rotateRight(tree, sibling);
+				sibling = parent->right;
+			}
+			sibling->red = parent->red;
+			parent->red = false;
+			sibling->right->red = false;
+			rotateLeft(tree, parent);
+		} else {
+			RBNode *sibling = parent->left;
+			if (isRed(sibling)) {
+				sibling->red = false;
+				parent->red = true;
+				rotateRight(tree, parent);
+				sibling = parent->left;
+			}
+			if (!isRed(sibling->left) && !isRed(sibling->right)) {
+				sibling->red = true;
+				child = parent;
+				parent = child->parent;
+				continue;
+			}
+			if (!isRed(sibling->left)) {
+				sibling->right->red = false;
+				sibling->red = true;
+				rotateLeft(tree, sibling);
+				sibling = parent->left;
+			}
+			sibling->red = parent->red;
+			parent->red = false;
+			sibling->left->red = false;
+			rotateRight(tree, parent);
+		}
+		child = tree->root;
+	}
+	if (child != NULL) child->red = false;
+}
+
+RBNode *rbtree_first(RBTree *tree) {
+	return tree->leftmost;
+}
+
+RBNode *rbtree_last(RBTree *tree) {
+	RBNode *node = tree->root;
+	if (node == NULL) return NULL;
+	while (node->right != NULL) node = node->right;
+	return node;
+}
+
+/* Returns the next node in order, or NULL if it's the last */
+RBNode *rbtree_next(RBNode *node) {
+	if (node->right != NULL) {
+		node = node->right;
+		while (node->left != NULL) node = node->left;
+		return node;
+	}
+	while (node->parent != NULL && node == node->parent->right) node = node->parent;
+	return node->parent;
+}
+
+bool rbtree_empty(RBTree *tree) {
+	return tree->root == NULL;
+}
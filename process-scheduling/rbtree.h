@@ -0,0 +1,34 @@
+/*
+ * rbtree.h 11/9/20
+ * Jared Diehl (jmddnb@umsystem.edu)
+ */
+
+#ifndef RBTREE_H
+#define RBTREE_H
+
+#include <stdbool.h>
+
+/* Embedded in whatever is being kept in order */
+typedef struct RBNode {
+	struct RBNode *parent, *left, *right;
+	bool red;
+} RBNode;
+
+typedef struct {
+	RBNode *root;
+	RBNode *leftmost; /* Cached so the smallest node is found in O(1) */
+	bool (*less)(RBNode*, RBNode*);
+	void (*update)(RBNode*); /* Recomputes whatever a node sums up over its subtree, or NULL if nothing is */
+	unsigned int size;
+} RBTree;
+
+void rbtree_initialize(RBTree*, bool (*)(RBNode*, RBNode*));
+void rbtree_augment(RBTree*, void (*)(RBNode*));
+void rbtree_insert(RBTree*, RBNode*);
+void rbtree_erase(RBTree*, RBNode*);
+RBNode *rbtree_first(RBTree*);
+RBNode *rbtree_last(RBTree*);
+RBNode *rbtree_next(RBNode*);
+bool rbtree_empty(RBTree*);
+
+#endif
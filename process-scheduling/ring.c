@@ -0,0 +1,49 @@
+/*
+ * ring.c 11/9/20
+ * Jared Diehl (jmddnb@umsystem.edu)
+ */
+
+#include <sched.h>
+#include <stdlib.h>
+
+#include "ring.h"
+#include "shared.h"
+
+/* Times the consumer polls an empty ring before going to sleep */
+#define RING_SPINS 100
+
+void ring_send(Ring *ring, int opcode, int percent) {
+	unsigned int head = ring->head;
+
+	/* Only full if the consumer has fallen behind, so give it a chance to catch up */
+	while (head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) == RING_SIZE) sched_yield();
+
+	Record *record = &ring->records[head % RING_SIZE];
+	record->opcode = opcode;
+	record->percent = percent;
+
+	/* Publish the record, then only pay for a wake-up if the consumer is asleep */
+	__atomic_store_n(&ring->head, head + 1, __ATOMIC_SEQ_CST);
+	if (__atomic_load_n(&ring->waiting, __ATOMIC_SEQ_CST)) wakeFutex(&ring->head);
+}
+
+void ring_receive(Ring *ring, Record *record) {
+	unsigned int tail = ring->tail;
+	int spins = 0;
+
+	while (__atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) == tail) {
+		if (++spins < RING_SPINS) continue;
+
+		/* Announce we're sleeping before checking one last time, so a send can't slip by unnoticed */
+		__atomic_store_n(&ring->waiting, 1, __ATOMIC_SEQ_CST);
+		if (__atomic_load_n(&ring->head, __ATOMIC_SEQ_CST) == tail) waitFutex(&ring->head, tail);
+		__atomic_store_n(&ring->waiting, 0, __ATOMIC_RELAXED);
+	}
+
+	*record = ring->records[tail % RING_SIZE];
+	__atomic_store_n(&ring->tail, tail + 1, __ATOMIC_RELEASE);
+}
+
+bool ring_empty(Ring *ring) {
+	return __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) == ring->tail;
+}
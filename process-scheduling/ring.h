@@ -0,0 +1,33 @@
+/*
+ * ring.h 11/9/20
+ * Jared Diehl (jmddnb@umsystem.edu)
+ */
+
+#ifndef RING_H
+#define RING_H
+
+#include <stdbool.h>
+
+/* Never more than two records are in flight between OSS and one user process */
+#define RING_SIZE 8
+
+enum OpcodeType { OPCODE_DISPATCH, OPCODE_TERMINATED, OPCODE_EXPIRED, OPCODE_BLOCKED };
+
+typedef struct {
+	unsigned char opcode;
+	unsigned char percent; /* Percent of the quantum used, if the opcode is a decision */
+} Record;
+
+/* Single-producer/single-consumer ring that lives in shared memory */
+typedef struct {
+	unsigned int head; /* Next slot to write, only written by the producer */
+	unsigned int tail; /* Next slot to read, only written by the consumer */
+	unsigned int waiting; /* Set while the consumer sleeps on head */
+	Record records[RING_SIZE];
+} Ring;
+
+void ring_send(Ring*, int, int);
+void ring_receive(Ring*, Record*);
+bool ring_empty(Ring*);
+
+#endif
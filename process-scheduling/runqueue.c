@@ -0,0 +1,142 @@
+/*
+ * runqueue.c 11/9/20
+ * Jared Diehl (jmddnb@umsystem.edu)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "runqueue.h"
+
+static int getSentinel(RunQueue *runqueue, unsigned int priority) {
+	return runqueue->capacity + 1 + priority;
+}
+
+static bool isSentinel(RunQueue *runqueue, int node) {
+	return node > runqueue->capacity;
+}
+
+static void setBit(RunQueue *runqueue, unsigned int priority) {
+	runqueue->bitmap[priority / 64] |= 1UL << (priority % 64);
+}
+
+static void clearBit(RunQueue *runqueue, unsigned int priority) {
+	runqueue->bitmap[priority / 64] &= ~(1UL << (priority % 64));
+}
+
+/* Unlinks the node from the priority's list, clearing its bit if that empties the list */
+static void detach(RunQueue *runqueue, unsigned int priority, int node) {
+	int prev = runqueue->prev[node], next = runqueue->next[node];
+	runqueue->next[prev] = next;
+	runqueue->prev[next] = prev;
+	runqueue->next[node] = runqueue->prev[node] = -1;
+	runqueue->counts[priority]--;
+	runqueue->size--;
+	
+	if (prev == next && isSentinel(runqueue, prev)) clearBit(runqueue, prev - runqueue->capacity - 1);
+}
+
+RunQueue *runqueue_create(unsigned int priorities, unsigned int capacity) {
+	RunQueue *runqueue = (RunQueue*) calloc(1, sizeof(RunQueue));
+	runqueue->priorities = priorities;
+	runqueue->capacity = capacity;
+	
+	unsigned int i, nodes = capacity + 1 + priorities;
+	runqueue->next = (int*) malloc(nodes * sizeof(int));
+	runqueue->prev = (int*) malloc(nodes * sizeof(int));
+	for (i = 0; i < nodes; i++)
+		runqueue->next[i] = runqueue->prev[i] = isSentinel(runqueue, i) ? i : -1;
+	
+	return runqueue;
+}
+
+void runqueue_push(RunQueue *runqueue, unsigned int priority, unsigned int item) {
+	if (item > runqueue->capacity || runqueue->next[item] != -1) return;
+	
+	int sentinel = getSentinel(runqueue, priority), tail = runqueue->prev[sentinel];
+	runqueue->next[tail] = item;
+	runqueue->prev[item] = tail;
+	runqueue->next[item] = sentinel;
+	runqueue->prev[sentinel] = item;
+	
+	setBit(runqueue, priority);
+	runqueue->counts[priority]++;
+	runqueue->size++;
+}
+
+unsigned int runqueue_pop(RunQueue *runqueue, unsigned int priority) {
+	int item = runqueue->next[getSentinel(runqueue, priority)];
+	if (isSentinel(runqueue, item)) return -1;
+	detach(runqueue, priority, item);
+	return item;
+}
+
+/* Takes the item pushed last at the priority */
+unsigned int runqueue_pop_rear(RunQueue *runqueue, unsigned int priority) {
+	int item = runqueue->prev[getSentinel(runqueue, priority)];
+	if (isSentinel(runqueue, item)) return -1;
+	detach(runqueue, priority, item);
+	return item;
+}
+
+/* Returns the item that would be popped next at the priority, or -1 if there's none */
+int runqueue_peek(RunQueue *runqueue, unsigned int priority) {
+	int item = runqueue->next[getSentinel(runqueue, priority)];
+	return isSentinel(runqueue, item) ? -1 : item;
+}
+
+unsigned int runqueue_count(RunQueue *runqueue, unsigned int priority) {
+	return runqueue->counts[priority];
+}
+
+/*
+ * Takes an item out from wherever it's queued, returning whether it was queued at all. A splice doesn't record
+ * which list the items it moves are on, so the priority comes from the sentinel at the end of the item's list.
+ * Unlike everything else here, that walk costs O(n) in the length of the list. Keeping splices O(1) is worth it,
+ * since they happen every second, while only mlfq's dequeue removes, and OSS never asks it to.
+ */
+bool runqueue_remove(RunQueue *runqueue, unsigned int item) {
+	if (item > runqueue->capacity || runqueue->next[item] == -1) return false;
+	int node = item;
+	while (!isSentinel(runqueue, node)) node = runqueue->next[node];
+	detach(runqueue, node - runqueue->capacity - 1, item);
+	return true;
+}
+
+/* Moves every item at the first priority to the back of the second, in order, without visiting any of them */
+void runqueue_splice(RunQueue *runqueue, unsigned int from, unsigned int to) {
+	int source = getSentinel(runqueue, from), target = getSentinel(runqueue, to);
+	if (from == to || isSentinel(runqueue, runqueue->next[source])) return;
+	
+	int first = runqueue->next[source], last = runqueue->prev[source], tail = runqueue->prev[target];
+	runqueue->next[tail] = first;
+	runqueue->prev[first] = tail;
+	runqueue->next[last] = target;
+	runqueue->prev[target] = last;
+	runqueue->next[source] = runqueue->prev[source] = source;
+	
+	runqueue->counts[to] += runqueue->counts[from];
+	runqueue->counts[from] = 0;
+	clearBit(runqueue, from);
+	setBit(runqueue, to);
+}
+
+/* Returns the highest non-empty priority, or -1 if every list is empty */
+int runqueue_first(RunQueue *runqueue) {
+	int i;
+	for (i = 0; i < RUNQUEUE_WORDS; i++)
+		if (runqueue->bitmap[i] != 0) return i * 64 + __builtin_ctzl(runqueue->bitmap[i]);
+	return -1;
+}
+
+/* Returns the lowest non-empty priority, or -1 if every list is empty */
+int runqueue_last(RunQueue *runqueue) {
+	int i;
+	for (i = RUNQUEUE_WORDS - 1; i >= 0; i--)
+		if (runqueue->bitmap[i] != 0) return i * 64 + 63 - __builtin_clzl(runqueue->bitmap[i]);
+	return -1;
+}
+
+bool runqueue_empty(RunQueue *runqueue) {
+	return runqueue->size == 0;
+}
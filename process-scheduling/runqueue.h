@@ -0,0 +1,41 @@
+/*
+ * runqueue.h 11/9/20
+ * Jared Diehl (jmddnb@umsystem.edu)
+ */
+
+#ifndef RUNQUEUE_H
+#define RUNQUEUE_H
+
+#include <stdbool.h>
+
+/* Enough for a priority range as wide as Linux's O(1) scheduler */
+#define RUNQUEUE_PRIORITIES_MAX 140
+#define RUNQUEUE_WORDS ((RUNQUEUE_PRIORITIES_MAX + 63) / 64)
+
+/*
+ * One FIFO list per priority, where a lower priority index runs first. Items are 0 through the capacity, such as
+ * local PIDs, and are linked through arrays indexed by item, followed by one sentinel per priority.
+ */
+typedef struct {
+	unsigned int priorities;
+	unsigned int capacity;
+	unsigned int size; /* Items queued across every priority */
+	unsigned long bitmap[RUNQUEUE_WORDS]; /* One bit per non-empty priority */
+	unsigned int counts[RUNQUEUE_PRIORITIES_MAX]; /* Items queued at each priority */
+	int *next; /* -1 if the item isn't queued */
+	int *prev;
+} RunQueue;
+
+RunQueue *runqueue_create(unsigned int, unsigned int);
+void runqueue_push(RunQueue*, unsigned int, unsigned int);
+unsigned int runqueue_pop(RunQueue*, unsigned int);
+unsigned int runqueue_pop_rear(RunQueue*, unsigned int);
+int runqueue_peek(RunQueue*, unsigned int);
+unsigned int runqueue_count(RunQueue*, unsigned int);
+bool runqueue_remove(RunQueue*, unsigned int);
+void runqueue_splice(RunQueue*, unsigned int, unsigned int);
+int runqueue_first(RunQueue*);
+int runqueue_last(RunQueue*);
+bool runqueue_empty(RunQueue*);
+
+#endif
@@ -0,0 +1,19 @@
+/*
+ * scheduler.c 11/9/20
+ * Jared Diehl (jmddnb@umsystem.edu)
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "scheduler.h"
+
+static SchedulerOps *schedulers[] = { &mlfqScheduler, &cfsScheduler, NULL };
+
+/* Returns the policy with the given name, or NULL if there's no such policy */
+SchedulerOps *getScheduler(char *name) {
+	int i;
+	for (i = 0; schedulers[i] != NULL; i++)
+		if (strcmp(schedulers[i]->name, name) == 0) return schedulers[i];
+	return NULL;
+}
@@ -0,0 +1,57 @@
+/*
+ * scheduler.h 11/9/20
+ * Jared Diehl (jmddnb@umsystem.edu)
+ */
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include "shared.h"
+
+#define GROUPS_MAX 16
+#define GROUP_PERIOD ((long) QUANTUM_BASE * 10) /* Quotas are of CPU time per this long */
+
+/* Operations OSS calls on the scheduling policy, where times are in nanoseconds and a process is queued on pcb->processor */
+typedef struct {
+	char *name;
+	void (*initialize)(unsigned int, unsigned int); /* Called once with the CPU count and the most processes there can be */
+	bool (*admit)(PCB*); /* Whether a new process can be taken on, or NULL if every process can */
+	void (*enqueue)(PCB*); /* A new process is runnable */
+	void (*dequeue)(PCB*); /* A runnable process is taken away without running */
+	PCB *(*pick_next)(unsigned int); /* Removes and returns the next process for the CPU to run, or NULL if there's none */
+	PCB *(*steal)(unsigned int, unsigned int); /* Removes a process queued on the first CPU for the second to run, or NULL if the class shares one queue */
+	unsigned int (*load)(unsigned int); /* Processes queued on the CPU */
+	unsigned int (*depth)(unsigned int); /* Processes queued at the priority across every CPU, which may walk the queues */
+	int (*quantum)(PCB*); /* Quantum for the process that was just picked */
+	bool (*preempts)(PCB*, PCB*); /* Whether a process that just became runnable should take the CPU from a running one, or NULL if it never should */
+	void (*on_tick)(PCB*, long); /* The running process used its entire quantum and is runnable again */
+	void (*on_preempt)(PCB*, long); /* The running process was taken off the CPU after running for the given time and is runnable again */
+	void (*on_block)(PCB*, long); /* The running process blocked after running for the given time */
+	void (*on_unblock)(PCB*); /* A blocked process is runnable again */
+	void (*on_exit)(PCB*, long); /* The running process terminated after running for the given time */
+	long (*refill)(); /* Time a process held back by a quota can run again, -1 if none is, or NULL if the policy has no quotas */
+} SchedulerOps;
+
+/* What the group policy keeps for each group, where times are in nanoseconds */
+typedef struct {
+	unsigned int weight;
+	long quota; /* CPU time per period, or 0 if there's no limit */
+	long cpu; /* CPU time its processes have had */
+	unsigned int processes;
+	unsigned int exited;
+	long turnaround; /* Summed over every process that exited */
+	unsigned int throttles; /* Periods it ran out of quota in */
+} GroupStats;
+
+extern SchedulerOps mlfqScheduler;
+extern SchedulerOps cfsScheduler;
+extern SchedulerOps edfScheduler; /* Real-time class, which runs ahead of whichever policy is picked */
+extern SchedulerOps groupScheduler; /* Picked with -g instead of by name */
+
+SchedulerOps *getScheduler(char*);
+unsigned int getDeadlineMisses();
+bool setGroups(char*);
+unsigned int getGroupCount();
+GroupStats *getGroupStats(unsigned int);
+
+#endif
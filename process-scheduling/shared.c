@@ -3,8 +3,11 @@
  * Jared Diehl (jmddnb@umsystem.edu)
  */
 
+#include <errno.h>
 #include <libgen.h>
-#include <math.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <sched.h>
 #include <signal.h>
 #include <stdarg.h>
 #include <stdio.h>
@@ -13,6 +16,7 @@
 #include <sys/msg.h>
 #include <sys/shm.h>
 #include <sys/stat.h>
+#include <sys/syscall.h>
 #include <sys/types.h>
 #include <unistd.h>
 
@@ -22,15 +26,19 @@
 
 static char *programName = NULL;
 
-static key_t shmkey;
-static int shmid;
+static int shmid = -1;
 static Shared *shmptr = NULL;
+static bool shmprivate = false; /* Whether shmptr is plain memory instead of a shared segment */
 
-static key_t pmsqkey;
-static int pmsqid;
+static int statsid = -1;
+static Stats *statsptr = NULL;
+static bool statsowner = false; /* Whether this process created the stats page, and so removes it */
 
-static key_t cmsqkey;
-static int cmsqid;
+static int pmsqid = -1;
+static int cmsqid = -1;
+
+static int queueQuanta[QUEUE_SET_COUNT]; /* Time at a priority before dropping a queue, or -1 if it never does */
+static int userQuanta[QUEUE_SET_COUNT];
 
 void init(int argc, char **argv) {
 	programName = argv[0];
@@ -65,42 +73,203 @@ char *getProgramName() {
 	return programName;
 }
 
-void allocateSharedMemory(bool init) {
-	if ((shmkey = ftok("./Makefile", 'a')) == -1) crash("ftok");
-	if ((shmid = shmget(shmkey, sizeof(Shared), PERMS | (init ? (IPC_EXCL | IPC_CREAT) : 0))) == -1) crash("shmget");
-	else shmptr = (Shared*) shmat(shmid, NULL, 0);
+/* The process table, dispatch rings, and decision rings each have an entry per local PID, which starts at 1 */
+static size_t getSharedSize(unsigned int concurrency) {
+	return sizeof(Shared) + (concurrency + 1) * (sizeof(PCB) + 2 * sizeof(Ring));
+}
+
+/* Exports an IPC identifier to the user processes forked after it */
+static void exportId(char *name, int id) {
+	char buf[BUFFER_LENGTH];
+	snprintf(buf, BUFFER_LENGTH, "%d", id);
+	if (setenv(name, buf, 1) == -1) crash("setenv");
+}
+
+/* Imports an IPC identifier exported by OSS */
+static int importId(char *name) {
+	char *value = getenv(name);
+	if (value == NULL) {
+		error("%s isn't set, so this wasn't started by OSS", name);
+		exit(EXIT_FAILURE);
+	}
+	return atoi(value);
+}
+
+/*
+ * OSS sizes the segment for the given concurrency, user processes attach to whatever size it is. It's private, and
+ * only found through the environment OSS forks with, so any number of simulations can run side by side.
+ */
+void allocateSharedMemory(bool init, unsigned int concurrency) {
+	if (init) {
+		if ((shmid = shmget(IPC_PRIVATE, getSharedSize(concurrency), PERMS | IPC_CREAT)) == -1) crash("shmget");
+		exportId(ENV_SHMID, shmid);
+	} else shmid = importId(ENV_SHMID);
+	if ((shmptr = (Shared*) shmat(shmid, NULL, 0)) == (void*) -1) {
+		shmptr = NULL;
+		crash("shmat");
+	}
+	if (init) shmptr->concurrency = concurrency;
+}
+
+/* Same layout as the shared segment, for when every process lives inside OSS */
+void allocatePrivateMemory(unsigned int concurrency) {
+	if ((shmptr = (Shared*) calloc(1, getSharedSize(concurrency))) == NULL) crash("calloc");
+	shmptr->concurrency = concurrency;
+	shmprivate = true;
 }
 
 void releaseSharedMemory() {
-	if (shmptr != NULL && shmdt(shmptr) == -1) crash("shmdt");
-	if (shmid > 0 && shmctl(shmid, IPC_RMID, NULL) == -1) crash("shmctl");
+	if (shmprivate) {
+		free(shmptr);
+		shmptr = NULL;
+		shmprivate = false;
+		return;
+	}
+	
+	/* Forgotten before anything can fail, since crash() comes back here */
+	Shared *ptr = shmptr;
+	int id = shmid;
+	shmptr = NULL;
+	shmid = -1;
+	if (ptr != NULL && shmdt(ptr) == -1) crash("shmdt");
+	if (id != -1 && shmctl(id, IPC_RMID, NULL) == -1) crash("shmctl");
 }
 
 Shared *getSharedMemory() {
 	return shmptr;
 }
 
-void allocateMessageQueues(bool init) {
-	if ((pmsqkey = ftok("./Makefile", 'b')) == -1) crash("ftok");
-	if ((pmsqid = msgget(pmsqkey, PERMS | (init ? (IPC_EXCL | IPC_CREAT) : 0))) == -1) crash("msgget");
+/* OSS to user process */
+Ring *getDispatchRing(unsigned int localPID) {
+	return (Ring*) &shmptr->ptable[shmptr->concurrency + 1] + localPID;
+}
+
+/* User process to OSS */
+Ring *getDecisionRing(unsigned int localPID) {
+	return (Ring*) &shmptr->ptable[shmptr->concurrency + 1] + (shmptr->concurrency + 1) + localPID;
+}
+
+static void getStatsPath(char *path, pid_t pid) {
+	snprintf(path, BUFFER_LENGTH, PATH_STATS, pid);
+}
+
+/*
+ * OSS passes its own PID to create the stats page, while anything else passes the PID of the OSS it wants and
+ * attaches to its page read-only. The page is private like the rest, and OSS leaves its identifier in a file named
+ * after its PID in the working directory, so several OSS can run there at once.
+ */
+void allocateStatsMemory(pid_t pid) {
+	char path[BUFFER_LENGTH];
+	getStatsPath(path, pid);
+	bool init = pid == getpid();
 	
-	if ((cmsqkey = ftok("./Makefile", 'c')) == -1) crash("ftok");
-	if ((cmsqid = msgget(cmsqkey, PERMS | (init ? (IPC_EXCL | IPC_CREAT) : 0))) == -1) crash("msgget");
+	FILE *fp;
+	if (init) {
+		if ((statsid = shmget(IPC_PRIVATE, sizeof(Stats), PERMS | IPC_CREAT)) == -1) crash("shmget");
+		if ((fp = fopen(path, "w")) == NULL) crash("fopen");
+		fprintf(fp, "%d\n", statsid);
+	} else {
+		if ((fp = fopen(path, "r")) == NULL) crash("fopen");
+		if (fscanf(fp, "%d", &statsid) != 1) {
+			error("%s doesn't hold a stats page yet", path);
+			exit(EXIT_FAILURE);
+		}
+	}
+	if (fclose(fp) == EOF) crash("fclose");
+	
+	if ((statsptr = (Stats*) shmat(statsid, NULL, init ? 0 : SHM_RDONLY)) == (void*) -1) {
+		statsptr = NULL;
+		crash("shmat");
+	}
+	
+	statsowner = init;
+	if (init) {
+		memset(statsptr, 0, sizeof(Stats));
+		statsptr->version = STATS_VERSION;
+	}
+}
+
+void releaseStatsMemory() {
+	if (statsptr == NULL) return;
+	
+	/* Let readers know nothing more is coming before the page goes away */
+	if (statsowner) {
+		beginStatsWrite();
+		statsptr->finished = true;
+		endStatsWrite();
+	}
+	
+	/* Forgotten before anything can fail, since crash() comes back here */
+	Stats *ptr = statsptr;
+	bool owner = statsowner;
+	statsptr = NULL;
+	statsowner = false;
+	if (shmdt(ptr) == -1) crash("shmdt");
+	if (owner) {
+		char path[BUFFER_LENGTH];
+		getStatsPath(path, getpid());
+		if (unlink(path) == -1 && errno != ENOENT) crash("unlink");
+		if (shmctl(statsid, IPC_RMID, NULL) == -1) crash("shmctl");
+	}
+}
+
+Stats *getStatsMemory() {
+	return statsptr;
+}
+
+/* Makes the sequence odd before any field changes */
+void beginStatsWrite() {
+	__atomic_store_n(&statsptr->sequence, statsptr->sequence + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+/* Makes the sequence even again once every field has changed */
+void endStatsWrite() {
+	__atomic_store_n(&statsptr->sequence, statsptr->sequence + 1, __ATOMIC_RELEASE);
+}
+
+/* Copies out a consistent snapshot, retrying if OSS wrote in the meantime, without taking any lock */
+void readStats(Stats *stats) {
+	unsigned int before, after;
+	do {
+		while ((before = __atomic_load_n(&statsptr->sequence, __ATOMIC_ACQUIRE)) & 1) sched_yield();
+		memcpy(stats, statsptr, sizeof(Stats));
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		after = __atomic_load_n(&statsptr->sequence, __ATOMIC_RELAXED);
+	} while (before != after);
+}
+
+/* Private like the shared segment */
+void allocateMessageQueues(bool init) {
+	if (init) {
+		if ((pmsqid = msgget(IPC_PRIVATE, PERMS | IPC_CREAT)) == -1) crash("msgget");
+		exportId(ENV_PMSQID, pmsqid);
+		if ((cmsqid = msgget(IPC_PRIVATE, PERMS | IPC_CREAT)) == -1) crash("msgget");
+		exportId(ENV_CMSQID, cmsqid);
+	} else {
+		pmsqid = importId(ENV_PMSQID);
+		cmsqid = importId(ENV_CMSQID);
+	}
 }
 
 void releaseMessageQueues() {
-	if (pmsqid > 0 && msgctl(pmsqid, IPC_RMID, NULL) == -1) crash("msgctl");
-	if (cmsqid > 0 && msgctl(cmsqid, IPC_RMID, NULL) == -1) crash("msgctl");
+	if (pmsqid != -1 && msgctl(pmsqid, IPC_RMID, NULL) == -1) crash("msgctl");
+	if (cmsqid != -1 && msgctl(cmsqid, IPC_RMID, NULL) == -1) crash("msgctl");
 }
 
+/* System V message calls are never restarted after a signal handler runs (e.g. the timeout), so retry them */
 int sendMessage(Message *message, int msqid, pid_t address, char *msg, bool wait) {
 	message->type = address;
 	strncpy(message->text, msg, BUFFER_LENGTH);
-	return msgsnd(msqid, message, sizeof(Message), wait ? 0 : IPC_NOWAIT);
+	int n;
+	while ((n = msgsnd(msqid, message, sizeof(message->text), wait ? 0 : IPC_NOWAIT)) == -1 && errno == EINTR);
+	return n;
 }
 
 int receiveMessage(Message *message, int msqid, pid_t address, bool wait) {
-	return msgrcv(msqid, message, sizeof(Message), address, wait ? 0 : IPC_NOWAIT);
+	int n;
+	while ((n = msgrcv(msqid, message, sizeof(message->text), address, wait ? 0 : IPC_NOWAIT)) == -1 && errno == EINTR);
+	return n;
 }
 
 int getParentQueue() {
@@ -111,7 +280,32 @@ int getChildQueue() {
 	return cmsqid;
 }
 
+/* Sleeps while the word still holds the value, which works across processes since it lives in shared memory */
+void waitFutex(unsigned int *address, unsigned int value) {
+	syscall(SYS_futex, address, FUTEX_WAIT, value, NULL, NULL, 0);
+}
+
+void wakeFutex(unsigned int *address) {
+	syscall(SYS_futex, address, FUTEX_WAKE, 1, NULL, NULL, 0);
+}
+
+/* Whether log lines are echoed to the console as well */
+static bool verbose = true;
+
+void setVerbose(bool value) {
+	verbose = value;
+}
+
+/* Whether log lines are written at all, since opening the log for every line dominates a long replay */
+static bool logging = true;
+
+void setLogging(bool value) {
+	logging = value;
+}
+
 void logger(char *fmt, ...) {
+	if (!logging) return;
+	
 	FILE *fp = fopen(PATH_LOG, "a+");
 	if (fp == NULL) crash("fopen");
 	
@@ -125,30 +319,32 @@ void logger(char *fmt, ...) {
 	snprintf(buff, BUFFER_LENGTH, "%s: [%010ld:%010ld] %s\n", basename(getProgramName()), shmptr->system.sec, shmptr->system.ns, buf);
 	
 	fprintf(fp, buff);
-	fprintf(stderr, buff);
+	if (verbose) fprintf(stderr, buff);
 	
 	fclose(fp);
 }
 
 void cleanup() {
+	releaseStatsMemory();
 	releaseSharedMemory();
 	releaseMessageQueues();
 }
 
+/* Carries whole seconds over with a division, since a long replay adds times of hours at once */
 void setTime(Time *time, long ns) {
 	time->sec = 0;
 	time->ns = ns;
-	while (time->ns >= 1e9) {
-		time->ns -= 1e9;
-		time->sec += 1;
+	if (time->ns >= 1000000000) {
+		time->sec += time->ns / 1000000000;
+		time->ns %= 1000000000;
 	}
 }
 
 void addTime(Time *time, long ns) {
 	time->ns += ns;
-	while (time->ns >= 1e9) {
-		time->ns -= 1e9;
-		time->sec += 1;
+	if (time->ns >= 1000000000) {
+		time->sec += time->ns / 1000000000;
+		time->ns %= 1000000000;
 	}
 }
 
@@ -161,6 +357,17 @@ void copyTime(Time *source, Time *target) {
 	memcpy(target, source, sizeof(Time));
 }
 
+/* Returns a negative, zero, or positive value if a is before, equal to, or after b */
+int compareTime(Time *a, Time *b) {
+	if (a->sec != b->sec) return a->sec < b->sec ? -1 : 1;
+	if (a->ns != b->ns) return a->ns < b->ns ? -1 : 1;
+	return 0;
+}
+
+long getNanoseconds(Time *time) {
+	return time->sec * 1000000000L + time->ns;
+}
+
 //void addTime(Time *time, int sec, int ns) {
 //	time->sec += sec;
 //	time->ns += ns;
@@ -187,7 +394,7 @@ void subTime(Time *a, Time *b) {
 	long epoch1 = a->sec * 1e9 + a->ns;
 	long epoch2 = b->sec * 1e9 + b->ns;
 	
-	long diff = abs(epoch1 - epoch2);
+	long diff = labs(epoch1 - epoch2);
 	
 	Time temp = { 0, 0 };
 	
@@ -205,11 +412,46 @@ void avgTime(Time *time, int count) {
 	time->ns = temp.ns;
 }
 
+static int getDefaultQueueQuantum(int queue) {
+	return queue > 0 && queue < QUEUE_SET_COUNT - 1 ? QUANTUM_BASE * (1 << queue) : -1;
+}
+
+/* Worked out once instead of on every dispatch, and only changed by scaleQuanta() after */
+void initializeQuanta() {
+	int i;
+	for (i = 0; i < QUEUE_SET_COUNT; i++) {
+		queueQuanta[i] = getDefaultQueueQuantum(i);
+		userQuanta[i] = getDefaultQuantum(i);
+	}
+}
+
 int getQueueQuantum(int queue) {
-	if (queue > 0 && queue < (QUEUE_SET_COUNT - 1)) return QUANTUM_BASE * pow(2, queue);
-	return -1;
+	return queueQuanta[queue];
 }
 
 int getUserQuantum(int queue) {
-	return QUANTUM_BASE / pow(2, queue);
+	return userQuanta[queue];
+}
+
+int getDefaultQuantum(int queue) {
+	return QUANTUM_BASE / (1 << queue);
+}
+
+/* Never less than a nanosecond, nor more than an int holds */
+static int scaleQuantum(int quantum, double scale) {
+	double scaled = quantum * scale;
+	if (scaled < 1) return 1;
+	return scaled > INT_MAX ? INT_MAX : (int) scaled;
+}
+
+/*
+ * Scales every normal queue's quantum from its default, along with the time it takes to drop from that queue, so
+ * a process still drops after the same number of quanta however long they are.
+ */
+void scaleQuanta(double scale) {
+	int i;
+	for (i = 1; i < QUEUE_SET_COUNT; i++) {
+		userQuanta[i] = scaleQuantum(getDefaultQuantum(i), scale);
+		if (queueQuanta[i] != -1) queueQuanta[i] = scaleQuantum(getDefaultQueueQuantum(i), scale);
+	}
 }
@@ -9,20 +9,34 @@
 #include <stdbool.h>
 #include <sys/types.h>
 
+#include "ring.h"
+
 #define BUFFER_LENGTH 1024
-#define PROCESSES_CONCURRENT_MAX 18
+#define PROCESSES_CONCURRENT_MAX 18 /* Default, see -s */
 #define PROCESSES_TOTAL_MAX 100
 #define TIMEOUT 3
 #define PATH_LOG "./output.log"
+#define PATH_USER "user" /* Next to OSS */
+#define PATH_STATS "oss.%d.stats" /* Identifier of the stats page of the OSS with that PID */
+
+/* Environment OSS hands the identifiers of its private IPC to user processes in */
+#define ENV_SHMID "OSS_SHMID"
+#define ENV_PMSQID "OSS_PMSQID"
+#define ENV_CMSQID "OSS_CMSQID"
 
 #define QUANTUM_BASE 1e7
 
 #define QUEUE_SET_COUNT 4
-#define QUEUE_SET_SIZE PROCESSES_CONCURRENT_MAX
-#define QUEUE_BLOCK_SIZE PROCESSES_CONCURRENT_MAX
+
+/* Bumped whenever the layout of Stats changes, so ossstat can refuse a page it doesn't understand */
+#define STATS_VERSION 1
 
 #define EXIT_STATUS_OFFSET 20
 
+enum DecisionType { DECISION_NONE, DECISION_TERMINATED, DECISION_EXPIRED, DECISION_BLOCKED };
+
+enum TransportType { TRANSPORT_MESSAGE, TRANSPORT_RING };
+
 typedef struct {
 	long type;
 	char text[BUFFER_LENGTH];
@@ -45,21 +59,64 @@ typedef struct {
 	Time block; /* Time spent blocked */
 	Time wait; /* Time spent waiting */
 	Time system; /* Time spent in system */
+	Time unblock; /* Time to be unblocked */
+	long blocked; /* Nanoseconds it decided to be blocked for, counted from when OSS acts on the decision */
+	Time response; /* Time from arrival until it first ran */
+	unsigned int dispatches; /* Times it was put on a CPU */
+	int decision; /* What the process decided to do with its quantum */
+	int quantum; /* Quantum the scheduling policy gave it when it was last scheduled */
+	int percent; /* Percent of its quantum the process used */
+	int remaining; /* Nanoseconds left before its decision takes effect, if it was preempted */
+	bool decided; /* Its decision has yet to take effect, so it isn't asked again when dispatched */
+	Time dispatched; /* Time it was last put on a CPU */
+	unsigned int processor; /* Simulated CPU it's queued on, or last ran on */
+	long period; /* Real-time period in nanoseconds, which is also its relative deadline */
+	Time deadline; /* Deadline of its current real-time job */
+	unsigned int wakeup; /* Bumped by OSS once the unblock time is reached, a blocked process sleeps on it */
+	long demand; /* Nanoseconds of CPU a replayed job still needs */
+	unsigned int seed; /* Seeds the user process' decisions, or 0 to seed them from the clock */
 } PCB;
 
 typedef struct {
 	Time system;
-	PCB ptable[PROCESSES_CONCURRENT_MAX];
+	int transport; /* How OSS and user processes exchange dispatches and decisions */
+	unsigned int concurrency; /* Most processes in the system at once, which sizes the process table and rings */
+	bool disks; /* Blocked processes wait on OSS's simulated disks instead of picking when they unblock */
+	PCB ptable[]; /* Indexed by local PID, which starts at 1, and followed by the rings */
 } Shared;
 
+/* Live counters OSS publishes for ossstat, behind a sequence lock so a reader never holds up the simulation */
+typedef struct {
+	unsigned int version; /* STATS_VERSION of the OSS that wrote it */
+	unsigned int sequence; /* Odd while OSS is writing */
+	bool finished; /* Set once the simulation is over */
+	Time clock;
+	unsigned int spawned;
+	unsigned int exited;
+	unsigned int running; /* CPUs running a process */
+	unsigned int dispatches;
+	unsigned int preemptions;
+	unsigned int depths[QUEUE_SET_COUNT]; /* Processes queued at each priority */
+} Stats;
+
 void init(int, char**);
 void error(char *fmt, ...);
 void crash(char*);
 char *getProgramName();
 
-void allocateSharedMemory(bool);
+void allocateSharedMemory(bool, unsigned int);
+void allocatePrivateMemory(unsigned int);
 void releaseSharedMemory();
 Shared *getSharedMemory();
+Ring *getDispatchRing(unsigned int);
+Ring *getDecisionRing(unsigned int);
+
+void allocateStatsMemory(pid_t);
+void releaseStatsMemory();
+Stats *getStatsMemory();
+void beginStatsWrite();
+void endStatsWrite();
+void readStats(Stats*);
 
 void allocateMessageQueues(bool);
 void releaseMessageQueues();
@@ -68,6 +125,9 @@ int receiveMessage(Message*, int, pid_t, bool);
 int getParentQueue();
 int getChildQueue();
 
+void waitFutex(unsigned int*, unsigned int);
+void wakeFutex(unsigned int*);
+
 void logger(char*, ...);
 void cleanup();
 
@@ -75,12 +135,20 @@ void setTime(Time*, long);
 void addTime(Time*, long);
 void clearTime(Time*);
 void copyTime(Time*, Time*);
+int compareTime(Time*, Time*);
+long getNanoseconds(Time*);
 Time subtractTime(Time*, Time*);
 void showTime(Time*);
 void subTime(Time*, Time*);
 void avgTime(Time*, int);
 
+void setVerbose(bool);
+void setLogging(bool);
+
+void initializeQuanta();
 int getQueueQuantum(int);
 int getUserQuantum(int);
+int getDefaultQuantum(int);
+void scaleQuanta(double);
 
 #endif
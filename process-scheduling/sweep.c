@@ -0,0 +1,449 @@
+/*
+ * sweep.c 11/9/20
+ * Jared Diehl (jmddnb@umsystem.edu)
+ */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <getopt.h>
+#include <libgen.h>
+#include <limits.h>
+#include <math.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "shared.h"
+
+/*
+ * Runs OSS over every combination of values of a set of its options, several replicas of each, and aggregates the
+ * summaries into means with 95% confidence intervals. Each replica runs in its own directory and is pinned to its
+ * own processor, along with the user processes it forks, and replica k of every point gets the same seed.
+ */
+
+#define AXES_MAX 8
+#define VALUES_MAX 64
+#define METRICS_MAX 128
+#define REPLICAS_DEFAULT 5
+#define SEED_DEFAULT 1
+#define PATH_OSS "oss" /* Next to sweep */
+#define PATH_RESULTS "./sweep.csv"
+#define PATH_RUNS "./runs"
+#define PATH_SUMMARY "summary.csv" /* In the directory of each replica */
+
+/* An option of OSS and the values it's swept over */
+typedef struct {
+	char option;
+	char *values[VALUES_MAX];
+	unsigned int count;
+} Axis;
+
+/* A replica running on a processor */
+typedef struct {
+	pid_t pid; /* 0 if the processor is free */
+	int processor;
+	unsigned int point;
+	unsigned int replica;
+} Slot;
+
+typedef struct {
+	Axis axes[AXES_MAX];
+	unsigned int axisCount;
+	unsigned int points; /* Combinations of values */
+	unsigned int replicas;
+	unsigned int seed; /* Of the first replica of each point */
+	char **options; /* Given to every replica */
+	int optionCount;
+	char ossPath[PATH_MAX];
+	char *resultsPath;
+	char *runsPath;
+	Slot *slots;
+	unsigned int slotCount;
+	char *metrics[METRICS_MAX]; /* In the order replicas first reported them */
+	unsigned int metricCount;
+	double *values; /* Indexed by point, metric and replica, and NAN where a replica didn't report */
+	unsigned int finished;
+	unsigned int failed;
+} Global;
+
+void usage(int);
+void initializeProgram(int, char**);
+bool addAxis(char*);
+void runSweep();
+void startReplica(Slot*, unsigned int, unsigned int);
+void finishReplica(Slot*, int);
+void readSummary(unsigned int, unsigned int);
+void writeResults();
+void writeField(FILE*, char*);
+char *getValue(unsigned int, unsigned int);
+void getRunPath(char*, unsigned int, unsigned int);
+double getCritical(unsigned int);
+
+static Global *global = NULL;
+
+/* Student's t for a two-sided 95% interval, by degrees of freedom */
+static double critical[] = { 12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228, 2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086, 2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042 };
+
+int main(int argc, char **argv) {
+	global = (Global*) calloc(1, sizeof(Global));
+	initializeProgram(argc, argv);
+	runSweep();
+	writeResults();
+	return global->failed > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+void usage(int status) {
+	if (status != EXIT_SUCCESS) fprintf(stderr, "Try '%s -h' for more information\n", getProgramName());
+	else {
+		printf("NAME\n");
+		printf("       %s - parameter sweeps of the OS process-scheduling simulator\n", getProgramName());
+		printf("USAGE\n");
+		printf("       %s [-h] [-d x] [-e x] [-j x] [-o x] [-r x] -s 'x values...' ... [-- oss options]\n", getProgramName());
+		printf("DESCRIPTION\n");
+		printf("       -h       : Prints usage information and exits\n");
+		printf("       -d x     : Directory each replica gets a directory of its own in (default %s)\n", PATH_RUNS);
+		printf("       -e x     : Seed of the first replica of each point, the rest counting up from it (default %d)\n", SEED_DEFAULT);
+		printf("       -j x     : Replicas run at once, each pinned to a processor (default every processor)\n");
+		printf("       -o x     : Where means and confidence intervals are written (default %s)\n", PATH_RESULTS);
+		printf("       -r x     : Replicas of each point (default %d)\n", REPLICAS_DEFAULT);
+		printf("       -s x     : An option of oss and the values it's swept over, separated by spaces, such as 'u 1 5 10'\n");
+		printf("                  Every combination of values of up to %d options is run\n", AXES_MAX);
+	}
+	exit(status);
+}
+
+void initializeProgram(int argc, char **argv) {
+	init(argc, argv);
+	
+	bool ok = true;
+	
+	global->replicas = REPLICAS_DEFAULT;
+	global->seed = SEED_DEFAULT;
+	global->resultsPath = PATH_RESULTS;
+	global->runsPath = PATH_RUNS;
+	
+	/* Replicas are pinned to the processors this may run on */
+	cpu_set_t allowed;
+	if (sched_getaffinity(0, sizeof(cpu_set_t), &allowed) == -1) crash("sched_getaffinity");
+	unsigned int jobs = CPU_COUNT(&allowed);
+	
+	while (true) {
+		/* Stop at the first non-option, since everything after it goes to OSS */
+		int c = getopt(argc, argv, "+hd:e:j:o:r:s:");
+		if (c == -1) break;
+		switch (c) {
+			case 'h':
+				usage(EXIT_SUCCESS);
+			case 'd':
+				global->runsPath = optarg;
+				break;
+			case 'e':
+				if (atol(optarg) < 1 || atol(optarg) > UINT_MAX) {
+					error("invalid seed '%s'", optarg);
+					ok = false;
+				} else global->seed = atol(optarg);
+				break;
+			case 'j':
+				if (atoi(optarg) < 1) {
+					error("invalid job count '%s'", optarg);
+					ok = false;
+				} else jobs = atoi(optarg);
+				break;
+			case 'o':
+				global->resultsPath = optarg;
+				break;
+			case 'r':
+				if (atoi(optarg) < 1) {
+					error("invalid replica count '%s'", optarg);
+					ok = false;
+				} else global->replicas = atoi(optarg);
+				break;
+			case 's':
+				if (!addAxis(optarg)) {
+					error("invalid sweep '%s' (at most %d options of %d values)", optarg, AXES_MAX, VALUES_MAX);
+					ok = false;
+				}
+				break;
+			default:
+				ok = false;
+		}
+	}
+	
+	global->options = &argv[optind];
+	global->optionCount = argc - optind;
+	
+	/* The seed and summary of every replica are the sweep's to pick */
+	int i;
+	for (i = 0; i < global->optionCount; i++) {
+		char *option = global->options[i];
+		if (option[0] == '-' && (option[1] == 'e' || option[1] == 'o')) {
+			error("options -e and -o of oss are set by the sweep");
+			ok = false;
+			break;
+		}
+	}
+	
+	if (global->axisCount == 0) {
+		error("nothing to sweep, give at least one -s");
+		ok = false;
+	}
+	
+	if (!ok) usage(EXIT_FAILURE);
+	
+	global->points = 1;
+	for (i = 0; i < global->axisCount; i++) global->points *= global->axes[i].count;
+	
+	/* OSS is run from inside each replica's directory, so it needs a path that works from anywhere */
+	char path[PATH_MAX];
+	char *copy = strdup(argv[0]);
+	snprintf(path, PATH_MAX, "%s/%s", dirname(copy), PATH_OSS);
+	free(copy);
+	if (realpath(path, global->ossPath) == NULL) crash("realpath");
+	
+	if (mkdir(global->runsPath, 0755) == -1 && errno != EEXIST) crash("mkdir");
+	
+	/* Never more processors than there are replicas to run */
+	global->slotCount = jobs < global->points * global->replicas ? jobs : global->points * global->replicas;
+	global->slots = (Slot*) calloc(global->slotCount, sizeof(Slot));
+	int cpu = -1;
+	unsigned int slot;
+	for (slot = 0; slot < global->slotCount; slot++) {
+		/* Wrap around the allowed processors if asked for more jobs than there are */
+		do cpu = (cpu + 1) % CPU_SETSIZE;
+		while (!CPU_ISSET(cpu, &allowed));
+		global->slots[slot].processor = cpu;
+	}
+	
+	size_t size = (size_t) global->points * METRICS_MAX * global->replicas;
+	global->values = (double*) malloc(size * sizeof(double));
+	size_t n;
+	for (n = 0; n < size; n++) global->values[n] = NAN;
+}
+
+/* Parses an option letter, with or without its dash, followed by its values */
+bool addAxis(char *spec) {
+	if (global->axisCount == AXES_MAX) return false;
+	
+	Axis *axis = &global->axes[global->axisCount];
+	char *copy = strdup(spec);
+	char *token = strtok(copy, " ");
+	if (token == NULL) return false;
+	if (token[0] == '-') token++;
+	if (strlen(token) != 1 || token[0] == 'e' || token[0] == 'o') return false;
+	axis->option = token[0];
+	
+	while ((token = strtok(NULL, " ")) != NULL) {
+		if (axis->count == VALUES_MAX) return false;
+		axis->values[axis->count++] = token;
+	}
+	if (axis->count == 0) return false;
+	
+	global->axisCount++;
+	return true;
+}
+
+/* Keeps every processor busy until every replica of every point has run, going through each point's first replica before any second */
+void runSweep() {
+	unsigned int total = global->points * global->replicas, next = 0, running = 0, i;
+	
+	for (i = 0; i < global->slotCount; i++) {
+		startReplica(&global->slots[i], next % global->points, next / global->points);
+		next++;
+		running++;
+	}
+	
+	while (running > 0) {
+		int status;
+		pid_t pid = waitpid(-1, &status, 0);
+		if (pid == -1) {
+			if (errno == EINTR) continue;
+			crash("waitpid");
+		}
+		
+		for (i = 0; i < global->slotCount; i++)
+			if (global->slots[i].pid == pid) break;
+		if (i == global->slotCount) continue;
+		
+		Slot *slot = &global->slots[i];
+		finishReplica(slot, status);
+		running--;
+		
+		if (next < total) {
+			startReplica(slot, next % global->points, next / global->points);
+			next++;
+			running++;
+		}
+	}
+}
+
+void startReplica(Slot *slot, unsigned int point, unsigned int replica) {
+	char path[PATH_MAX], summary[PATH_MAX + sizeof(PATH_SUMMARY)];
+	getRunPath(path, point, replica);
+	if (mkdir(path, 0755) == -1 && errno != EEXIST) crash("mkdir");
+	
+	/* Never read a summary left over from an earlier sweep */
+	snprintf(summary, sizeof(summary), "%s/%s", path, PATH_SUMMARY);
+	if (unlink(summary) == -1 && errno != ENOENT) crash("unlink");
+	
+	slot->point = point;
+	slot->replica = replica;
+	
+	if ((slot->pid = fork()) == -1) crash("fork");
+	else if (slot->pid > 0) return;
+	
+	/* Pinned before OSS forks any user processes, so they all stay on the same processor */
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(slot->processor, &set);
+	if (sched_setaffinity(0, sizeof(cpu_set_t), &set) == -1) crash("sched_setaffinity");
+	
+	if (chdir(path) == -1) crash("chdir");
+	if (freopen("stdout", "w", stdout) == NULL) crash("freopen");
+	if (freopen("stderr", "w", stderr) == NULL) crash("freopen");
+	
+	char seed[BUFFER_LENGTH], options[AXES_MAX][3];
+	snprintf(seed, BUFFER_LENGTH, "%u", global->seed + replica);
+	
+	char **args = (char**) calloc(global->optionCount + 2 * global->axisCount + 6, sizeof(char*));
+	int n = 0, i;
+	args[n++] = global->ossPath; /* Where OSS finds the user program */
+	for (i = 0; i < global->optionCount; i++) args[n++] = global->options[i];
+	for (i = 0; i < global->axisCount; i++) {
+		snprintf(options[i], 3, "-%c", global->axes[i].option);
+		args[n++] = options[i];
+		args[n++] = getValue(point, i);
+	}
+	args[n++] = "-e";
+	args[n++] = seed;
+	args[n++] = "-o";
+	args[n++] = PATH_SUMMARY;
+	args[n] = NULL;
+	
+	execv(global->ossPath, args);
+	crash("execv");
+}
+
+void finishReplica(Slot *slot, int status) {
+	char path[PATH_MAX];
+	getRunPath(path, slot->point, slot->replica);
+	slot->pid = 0;
+	global->finished++;
+	
+	/* A failed replica is left out of the results, and its directory kept to see why */
+	if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS) {
+		global->failed++;
+		error("%s failed, see %s/stderr", path, path);
+		return;
+	}
+	
+	readSummary(slot->point, slot->replica);
+	printf("%s done (%u of %u)\n", path, global->finished, global->points * global->replicas);
+}
+
+void readSummary(unsigned int point, unsigned int replica) {
+	char path[PATH_MAX], line[BUFFER_LENGTH];
+	getRunPath(path, point, replica);
+	strncat(path, "/" PATH_SUMMARY, PATH_MAX - strlen(path) - 1);
+	
+	FILE *fp;
+	if ((fp = fopen(path, "r")) == NULL) {
+		global->failed++;
+		error("%s: %s", path, strerror(errno));
+		return;
+	}
+	
+	while (fgets(line, BUFFER_LENGTH, fp) != NULL) {
+		char *comma = strchr(line, ',');
+		if (comma == NULL) continue;
+		*comma = '\0';
+		
+		/* Metrics are added as they're first seen, since some only show up for some points */
+		unsigned int metric;
+		for (metric = 0; metric < global->metricCount; metric++)
+			if (strcmp(global->metrics[metric], line) == 0) break;
+		if (metric == global->metricCount) {
+			if (metric == METRICS_MAX) continue;
+			global->metrics[global->metricCount++] = strdup(line);
+		}
+		
+		global->values[((size_t) point * METRICS_MAX + metric) * global->replicas + replica] = atof(comma + 1);
+	}
+	
+	if (fclose(fp) == EOF) crash("fclose");
+}
+
+/* One line per point and metric, with the sample mean and standard deviation over the replicas that reported it */
+void writeResults() {
+	FILE *fp;
+	if ((fp = fopen(global->resultsPath, "w")) == NULL) crash("fopen");
+	
+	unsigned int i, point, metric, replica;
+	for (i = 0; i < global->axisCount; i++) fprintf(fp, "%c,", global->axes[i].option);
+	fprintf(fp, "metric,replicas,mean,stddev,ci95_low,ci95_high\n");
+	
+	for (point = 0; point < global->points; point++) {
+		for (metric = 0; metric < global->metricCount; metric++) {
+			double *values = &global->values[((size_t) point * METRICS_MAX + metric) * global->replicas];
+			unsigned int n = 0;
+			double sum = 0, squares = 0;
+			for (replica = 0; replica < global->replicas; replica++) {
+				if (isnan(values[replica])) continue;
+				n++;
+				sum += values[replica];
+			}
+			if (n == 0) continue;
+			double mean = sum / n;
+			for (replica = 0; replica < global->replicas; replica++)
+				if (!isnan(values[replica])) squares += (values[replica] - mean) * (values[replica] - mean);
+			
+			for (i = 0; i < global->axisCount; i++) {
+				writeField(fp, getValue(point, i));
+				fprintf(fp, ",");
+			}
+			fprintf(fp, "%s,%u,%.9g", global->metrics[metric], n, mean);
+			
+			/* A single replica says nothing about the spread */
+			if (n > 1) {
+				double stddev = sqrt(squares / (n - 1));
+				double half = getCritical(n - 1) * stddev / sqrt(n);
+				fprintf(fp, ",%.9g,%.9g,%.9g\n", stddev, mean - half, mean + half);
+			} else fprintf(fp, ",,,\n");
+		}
+	}
+	
+	if (fclose(fp) == EOF) crash("fclose");
+	printf("%u of %u replicas done, results in %s\n", global->finished - global->failed, global->points * global->replicas, global->resultsPath);
+}
+
+/* Quotes values such as an mmpp arrival process, which have commas of their own */
+void writeField(FILE *fp, char *value) {
+	if (strchr(value, ',') == NULL) fprintf(fp, "%s", value);
+	else fprintf(fp, "\"%s\"", value);
+}
+
+/* The last axis changes fastest from one point to the next */
+char *getValue(unsigned int point, unsigned int axis) {
+	int i;
+	for (i = global->axisCount - 1; i > (int) axis; i--) point /= global->axes[i].count;
+	return global->axes[axis].values[point % global->axes[axis].count];
+}
+
+void getRunPath(char *path, unsigned int point, unsigned int replica) {
+	snprintf(path, PATH_MAX, "%s/p%u-r%u", global->runsPath, point, replica);
+}
+
+/* Past the table, the value at its lower end of each range errs on the side of a wider interval */
+double getCritical(unsigned int df) {
+	if (df <= sizeof(critical) / sizeof(critical[0])) return critical[df - 1];
+	if (df <= 40) return 2.042;
+	if (df <= 60) return 2.021;
+	if (df <= 120) return 2.000;
+	return 1.980;
+}
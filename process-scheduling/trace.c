@@ -0,0 +1,100 @@
+/*
+ * trace.c 11/9/20
+ * Jared Diehl (jmddnb@umsystem.edu)
+ */
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "trace.h"
+
+static bool isBlank(char c) {
+	return c == ' ' || c == '\t' || c == '\r';
+}
+
+/* Parses the next field of the line as a whole number, dropping any fraction, or returns false at the end of it */
+static bool parseField(char **cursor, char *end, long *value) {
+	char *p = *cursor;
+	while (p < end && isBlank(*p)) p++;
+	if (p == end) return false;
+	
+	bool negative = *p == '-';
+	if (negative) p++;
+	
+	long n = 0;
+	while (p < end && *p >= '0' && *p <= '9') n = n * 10 + (*p++ - '0');
+	while (p < end && !isBlank(*p)) p++;
+	
+	*value = negative ? -n : n;
+	*cursor = p;
+	return true;
+}
+
+/* Maps the whole log up front, so reading it is just walking memory the kernel pages in as it goes */
+Trace *trace_open(char *path) {
+	int fd = open(path, O_RDONLY);
+	if (fd == -1) return NULL;
+	
+	struct stat st;
+	if (fstat(fd, &st) == -1) {
+		close(fd);
+		return NULL;
+	}
+	
+	Trace *trace = (Trace*) calloc(1, sizeof(Trace));
+	trace->size = st.st_size;
+	if (trace->size > 0) {
+		trace->data = mmap(NULL, trace->size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (trace->data == MAP_FAILED) {
+			close(fd);
+			free(trace);
+			return NULL;
+		}
+		madvise(trace->data, trace->size, MADV_SEQUENTIAL);
+	}
+	
+	close(fd);
+	return trace;
+}
+
+/* Reads the next job, skipping comments and jobs that can't be replayed, or returns false once there are none */
+bool trace_next(Trace *trace, Job *job) {
+	while (trace->offset < trace->size) {
+		char *line = trace->data + trace->offset;
+		char *end = memchr(line, '\n', trace->size - trace->offset);
+		if (end == NULL) end = trace->data + trace->size;
+		trace->offset = end - trace->data + 1;
+		
+		/* Header lines start with a semicolon */
+		while (line < end && isBlank(*line)) line++;
+		if (line == end || *line == ';') continue;
+		
+		long fields[SWF_FIELDS];
+		int count = 0;
+		while (count < SWF_FIELDS && parseField(&line, end, &fields[count])) count++;
+		
+		if (count <= SWF_RUN || fields[SWF_RUN] < 0) {
+			trace->skipped++;
+			continue;
+		}
+		
+		job->submit = fields[SWF_SUBMIT];
+		job->run = fields[SWF_RUN];
+		job->processors = count > SWF_REQUESTED && fields[SWF_REQUESTED] > 0 ? fields[SWF_REQUESTED] : count > SWF_ALLOCATED ? fields[SWF_ALLOCATED] : 1;
+		if (job->processors < 1) job->processors = 1;
+		job->estimate = count > SWF_ESTIMATE ? fields[SWF_ESTIMATE] : -1;
+		if (job->estimate < job->run) job->estimate = job->run;
+		job->queue = count > SWF_QUEUE ? fields[SWF_QUEUE] : -1;
+		return true;
+	}
+	return false;
+}
+
+void trace_close(Trace *trace) {
+	if (trace->size > 0) munmap(trace->data, trace->size);
+	free(trace);
+}
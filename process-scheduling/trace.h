@@ -0,0 +1,42 @@
+/*
+ * trace.h 11/9/20
+ * Jared Diehl (jmddnb@umsystem.edu)
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Fields on each line of a Standard Workload Format log, of which only a few are used */
+#define SWF_FIELDS 18
+#define SWF_SUBMIT 1
+#define SWF_RUN 3
+#define SWF_ALLOCATED 4
+#define SWF_REQUESTED 7
+#define SWF_ESTIMATE 8
+#define SWF_QUEUE 14
+
+/* One job of the log, where times are in seconds */
+typedef struct {
+	long submit; /* Since the log started */
+	long run;
+	long processors; /* Processors it asked for, or was given if the log doesn't say */
+	long estimate; /* Run time it asked for, or its actual run time if that's longer or the log doesn't say */
+	long queue; /* Queue it was submitted to, where 0 means an interactive job */
+} Job;
+
+/* Standard Workload Format log, mapped into memory and parsed one line at a time */
+typedef struct {
+	char *data;
+	size_t size;
+	size_t offset; /* Start of the next line */
+	unsigned long skipped; /* Jobs left out because their run time is unknown */
+} Trace;
+
+Trace *trace_open(char*);
+bool trace_next(Trace*, Job*);
+void trace_close(Trace*);
+
+#endif
@@ -10,35 +10,48 @@
 #include <time.h>
 #include <unistd.h>
 
+#include "decision.h"
 #include "shared.h"
 #include "user.h"
 
 typedef struct {
 	Shared *shared;
 	PCB *pcb;
+	Ring *dispatch;
+	Ring *decisions;
 	Message message;
+	bool terminated;
 } Global;
 
-void initializeProgram(int, char**);
-void simulateUser();
+int initializeProgram(int, char**);
+void simulateWorker();
+void simulateUser(int);
 
 void simulateProcessTerminated();
 void simulateProcessExpired();
 void simulateProcessBlocked();
-
-bool shouldTerminate(PCB*);
-bool shouldExpire(PCB*);
+void waitDispatch();
+void sendDecision(int, int);
 
 static Global *global = NULL;
 
 int main(int argc, char **argv) {
-	global = (Global*) malloc(sizeof(Global));
-	initializeProgram(argc, argv);
-	simulateUser();
+	global = (Global*) calloc(1, sizeof(Global));
+	int localPID = initializeProgram(argc, argv);
+	
+	srand(time(NULL) ^ (getpid() << 16));
+	
+	/* A local PID of 0 means we're a pooled worker that gets assigned simulated processes */
+	if (localPID == 0) simulateWorker();
+	else {
+		simulateUser(localPID);
+		exit(EXIT_STATUS_OFFSET + localPID);
+	}
+	
 	return EXIT_SUCCESS;
 }
 
-void initializeProgram(int argc, char **argv) {
+int initializeProgram(int argc, char **argv) {
 	init(argc, argv);
 	
 	int localPID;
@@ -48,20 +61,41 @@ void initializeProgram(int argc, char **argv) {
 		exit(EXIT_FAILURE);
 	} else localPID = atoi(argv[1]);
 	
-	allocateSharedMemory(false);
+	allocateSharedMemory(false, 0);
 	allocateMessageQueues(false);
 	
 	global->shared = getSharedMemory();
-	global->pcb = &global->shared->ptable[localPID];
+	
+	return localPID;
 }
 
-void simulateUser() {
-	srand(time(NULL) ^ (getpid() << 16));
-	
-	/* Infinite loop until we've terminated */
+void simulateWorker() {
 	while (true) {
-		/* Check if we've received a message to simulate running */
-		receiveMessage(&global->message, getChildQueue(), global->pcb->actualPID, true);
+		/* Wait for OSS to assign us a local PID, where 0 means the pool is shutting down */
+		receiveMessage(&global->message, getChildQueue(), getpid(), true);
+		int localPID = atoi(global->message.text);
+		if (localPID == 0) break;
+		
+		/* Go back to the pool once the simulated process terminates */
+		simulateUser(localPID);
+	}
+}
+
+void simulateUser(int localPID) {
+	global->pcb = &global->shared->ptable[localPID];
+	global->dispatch = getDispatchRing(localPID);
+	global->decisions = getDecisionRing(localPID);
+	global->terminated = false;
+	bool seeded = false;
+	
+	/* Loop until we've terminated */
+	while (!global->terminated) {
+		/* Wait until OSS tells us to simulate running */
+		waitDispatch();
+		
+		/* Only once dispatched is the PCB sure to be filled in, so a seeded run makes the same decisions every time */
+		if (!seeded && global->pcb->seed != 0) srand(global->pcb->seed);
+		seeded = true;
 		
 		/* Simulate running */
 		if (shouldTerminate(global->pcb)) simulateProcessTerminated();
@@ -71,55 +105,53 @@ void simulateUser() {
 }
 
 void simulateProcessTerminated() {
-	/* Send a message to OSS saying we're terminating */
-	sendMessage(&global->message, getParentQueue(), global->pcb->actualPID, "TERMINATED", true);
-	
-	/* Compute a random percentage from 1 to 99 */
-	int rp = (rand() % 99) + 1;
-	char buf[BUFFER_LENGTH];
-	snprintf(buf, BUFFER_LENGTH, "%d", rp);
-	
-	/* Send a message to OSS saying the percent of our user-quantum we've used */
-	sendMessage(&global->message, getParentQueue(), global->pcb->actualPID, buf, true);
+	/* Tell OSS we're terminating after using a random 1 to 99 percent of our user-quantum */
+	sendDecision(OPCODE_TERMINATED, getUsedPercent());
 	
-	exit(EXIT_STATUS_OFFSET + global->pcb->localPID);
+	global->terminated = true;
 }
 
 void simulateProcessExpired() {
-	/* Send a message to OSS saying we've used our entire user-quantum */
-	sendMessage(&global->message, getParentQueue(), global->pcb->actualPID, "EXPIRED", true);
+	/* Tell OSS we've used our entire user-quantum */
+	sendDecision(OPCODE_EXPIRED, 100);
 }
 
 void simulateProcessBlocked() {
-	/* Send a message to OSS saying we're getting blocked */
-	sendMessage(&global->message, getParentQueue(), global->pcb->actualPID, "BLOCKED", false);
+	/* Pick how long this user process will be blocked for, before OSS hears we're blocked */
+	if (!global->shared->disks) global->pcb->blocked = getBlockedDuration();
 	
-	/* Compute a random percentage from 1 to 99 */
-	int rp = (rand() % 99) + 1;
-	char buf[BUFFER_LENGTH];
-	snprintf(buf, BUFFER_LENGTH, "%d", rp);
+	unsigned int *wakeup = &global->pcb->wakeup;
+	unsigned int seen = __atomic_load_n(wakeup, __ATOMIC_ACQUIRE);
 	
-	/* Send a message to OSS saying the percent of our user-quantum we've used */
-	sendMessage(&global->message, getParentQueue(), global->pcb->actualPID, buf, true);
+	/* Tell OSS we're getting blocked after using a random 1 to 99 percent of our user-quantum */
+	sendDecision(OPCODE_BLOCKED, getUsedPercent());
 	
-	/* Set a time in the future when this user process will be unblocked */
-	Time unblock = { .sec = global->shared->system.sec, .ns = global->shared->system.ns };
-	int addsec = rand() % (3 + 1);
-	int addns = rand() % (1000 + 1);
-	addTime(&unblock, addsec * 1e9 + addns);
-	addTime(&global->pcb->block, addsec * 1e9 + addns);
-	
-	/* Busy-wait until the unblock time is reached */
-	while (!(global->shared->system.sec >= unblock.sec && global->shared->system.ns >= unblock.ns));
-	
-	/* Send a message to OSS saying we're not unblocked */
-	sendMessage(&global->message, getParentQueue(), global->pcb->actualPID, "UNBLOCKED", false);
+	/* Sleep until OSS reaches the unblock time and wakes us, instead of spinning on the clock */
+	while (__atomic_load_n(wakeup, __ATOMIC_ACQUIRE) == seen) waitFutex(wakeup, seen);
 }
 
-bool shouldTerminate(PCB *pcb) {
-	return rand() % 100 < (CHANCE_PROCESS_TERMINATES * (pcb->priority == 0 ? 2 : 1));
+void waitDispatch() {
+	if (global->shared->transport == TRANSPORT_RING) {
+		Record record;
+		ring_receive(global->dispatch, &record);
+	} else receiveMessage(&global->message, getChildQueue(), getpid(), true);
 }
 
-bool shouldExpire(PCB *pcb) {
-	return rand() % 100 < CHANCE_PROCESS_EXPIRES;
+/* Over rings the decision and percent go in one record, otherwise the percent follows in its own message */
+void sendDecision(int opcode, int percent) {
+	if (global->shared->transport == TRANSPORT_RING) {
+		ring_send(global->decisions, opcode, percent);
+		return;
+	}
+	
+	char *text = "BLOCKED";
+	if (opcode == OPCODE_TERMINATED) text = "TERMINATED";
+	else if (opcode == OPCODE_EXPIRED) text = "EXPIRED";
+	sendMessage(&global->message, getParentQueue(), global->pcb->actualPID, text, true);
+	
+	if (opcode != OPCODE_EXPIRED) {
+		char buf[BUFFER_LENGTH];
+		snprintf(buf, BUFFER_LENGTH, "%d", percent);
+		sendMessage(&global->message, getParentQueue(), global->pcb->actualPID, buf, true);
+	}
 }
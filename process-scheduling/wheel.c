@@ -0,0 +1,98 @@
+/*
+ * wheel.c 11/9/20
+ * Jared Diehl (jmddnb@umsystem.edu)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "wheel.h"
+
+/*
+ * A timer sits on the level of the highest 6-bit group where its expiry differs from the wheel's time, in the
+ * slot given by its expiry's bits on that level. So every timer on a level shares all higher bits with the wheel's
+ * time, and lower levels and slots always expire first.
+ */
+static void link(Wheel *wheel, WheelTimer *timer) {
+	unsigned long delta = timer->expiry ^ wheel->now;
+	timer->level = delta == 0 ? 0 : (63 - __builtin_clzl(delta)) / WHEEL_BITS;
+	timer->slot = (timer->expiry >> (timer->level * WHEEL_BITS)) & (WHEEL_SLOTS - 1);
+
+	WheelTimer **head = &wheel->slots[timer->level][timer->slot];
+	timer->prev = NULL;
+	timer->next = *head;
+	if (*head != NULL) (*head)->prev = timer;
+	*head = timer;
+	wheel->occupied[timer->level] |= 1UL << timer->slot;
+}
+
+static void unlink(Wheel *wheel, WheelTimer *timer) {
+	WheelTimer **head = &wheel->slots[timer->level][timer->slot];
+	if (timer->prev != NULL) timer->prev->next = timer->next;
+	else *head = timer->next;
+	if (timer->next != NULL) timer->next->prev = timer->prev;
+	if (*head == NULL) wheel->occupied[timer->level] &= ~(1UL << timer->slot);
+	timer->prev = timer->next = NULL;
+}
+
+Wheel *wheel_create() {
+	return (Wheel*) calloc(1, sizeof(Wheel));
+}
+
+/* Timers that would expire in the past expire as soon as possible instead */
+void wheel_add(Wheel *wheel, WheelTimer *timer, unsigned long expiry) {
+	timer->expiry = expiry < wheel->now ? wheel->now : expiry;
+	link(wheel, timer);
+	wheel->size++;
+}
+
+void wheel_cancel(Wheel *wheel, WheelTimer *timer) {
+	unlink(wheel, timer);
+	wheel->size--;
+}
+
+/* Gets the earliest expiry, which only means looking through one slot */
+bool wheel_next(Wheel *wheel, unsigned long *expiry) {
+	int level;
+	for (level = 0; level < WHEEL_LEVELS; level++) {
+		if (wheel->occupied[level] == 0) continue;
+		WheelTimer *timer = wheel->slots[level][__builtin_ctzl(wheel->occupied[level])];
+		*expiry = timer->expiry;
+		for (; timer != NULL; timer = timer->next)
+			if (timer->expiry < *expiry) *expiry = timer->expiry;
+		return true;
+	}
+	return false;
+}
+
+/* Moves the wheel's time forward, which must never be past the earliest expiry */
+void wheel_advance(Wheel *wheel, unsigned long time) {
+	if (time <= wheel->now) return;
+	wheel->now = time;
+
+	/* Timers in the slot under the new time now share one more group of bits with it, so they cascade down */
+	int level;
+	for (level = 1; level < WHEEL_LEVELS; level++) {
+		int slot = (time >> (level * WHEEL_BITS)) & (WHEEL_SLOTS - 1);
+		WheelTimer *timer = wheel->slots[level][slot];
+		wheel->slots[level][slot] = NULL;
+		wheel->occupied[level] &= ~(1UL << slot);
+		while (timer != NULL) {
+			WheelTimer *next = timer->next;
+			link(wheel, timer);
+			timer = next;
+		}
+	}
+}
+
+/* Removes a timer expiring at the wheel's current time, if any */
+WheelTimer *wheel_pop(Wheel *wheel) {
+	WheelTimer *timer = wheel->slots[0][wheel->now & (WHEEL_SLOTS - 1)];
+	if (timer == NULL) return NULL;
+	wheel_cancel(wheel, timer);
+	return timer;
+}
+
+bool wheel_empty(Wheel *wheel) {
+	return wheel->size == 0;
+}
@@ -0,0 +1,39 @@
+/*
+ * wheel.h 11/9/20
+ * Jared Diehl (jmddnb@umsystem.edu)
+ */
+
+#ifndef WHEEL_H
+#define WHEEL_H
+
+#include <stdbool.h>
+
+/* 11 levels of 64 slots cover every 64-bit nanosecond time, so nothing ever overflows the wheel */
+#define WHEEL_LEVELS 11
+#define WHEEL_SLOTS 64
+#define WHEEL_BITS 6
+
+typedef struct WheelTimer {
+	unsigned long expiry; /* Simulated time in nanoseconds */
+	unsigned int localPID;
+	int level, slot; /* Where the timer currently sits */
+	struct WheelTimer *prev, *next;
+} WheelTimer;
+
+/* Hierarchical timer wheel keyed by simulated time */
+typedef struct {
+	unsigned long now; /* Time the wheel has advanced to, never past the earliest expiry */
+	unsigned long occupied[WHEEL_LEVELS]; /* One bit per non-empty slot */
+	WheelTimer *slots[WHEEL_LEVELS][WHEEL_SLOTS];
+	unsigned int size;
+} Wheel;
+
+Wheel *wheel_create();
+void wheel_add(Wheel*, WheelTimer*, unsigned long);
+void wheel_cancel(Wheel*, WheelTimer*);
+bool wheel_next(Wheel*, unsigned long*);
+void wheel_advance(Wheel*, unsigned long);
+WheelTimer *wheel_pop(Wheel*);
+bool wheel_empty(Wheel*);
+
+#endif
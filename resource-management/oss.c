@@ -25,6 +25,7 @@
 
 #include "shared.h"
 #include "queue.h"
+#include "reaper.h"
 
 #define log _log
 
@@ -35,10 +36,17 @@ void simulate();
 void handleProcesses();
 void trySpawnProcess();
 void spawnProcess(int);
+pid_t forkUser(int);
+void createWorkerPool();
+void releaseWorkerPool();
+pid_t assignWorker(int);
+void releaseWorker(int);
 void initPCB(pid_t, int);
 int findAvailablePID();
 void advanceClock();
 bool safe(Queue*, int, int[RESOURCES_MAX]);
+void publishStats();
+void reapProcesses(bool);
 
 /* Program lifecycle functions */
 void init(int, char**);
@@ -67,7 +75,9 @@ static volatile bool quit = false;
 static int shmid = -1;
 static int msqid = -1;
 static int semid = -1;
+static int statsid = -1;
 static System *system = NULL;
+static Stats *stats = NULL;
 static Message message;
 
 /* Simulation variables */
@@ -78,7 +88,17 @@ static ResourceDescriptor descriptor;
 static int activeCount = 0;
 static int spawnCount = 0;
 static int exitCount = 0;
+static int exitPending = 0; /* User processes that said they're terminating but haven't been reaped */
+static Reaper reaper;
+static int requestCount = 0;
+static int grantCount = 0;
+static int denyCount = 0;
+static int releaseCount = 0;
 static pid_t pids[PROCESSES_MAX];
+static bool pooled = false;
+static pid_t workers[PROCESSES_MAX]; /* Pre-forked user processes */
+static pid_t pool[PROCESSES_MAX]; /* Pre-forked user processes not assigned a simulated PID */
+static int poolSize = 0;
 
 int main(int argc, char **argv) {
 	init(argc, argv);
@@ -89,7 +109,7 @@ int main(int argc, char **argv) {
 
 	/* Get program arguments */
 	while (true) {
-		int c = getopt(argc, argv, "hv");
+		int c = getopt(argc, argv, "hvw");
 		if (c == -1) break;
 		switch (c) {
 			case 'h':
@@ -97,6 +117,9 @@ int main(int argc, char **argv) {
 			case 'v':
 				verbose = true;
 				break;
+			case 'w':
+				pooled = true;
+				break;
 			default:
 				ok = false;
 		}
@@ -125,6 +148,7 @@ int main(int argc, char **argv) {
 
 	/* Setup simulation */
 	initIPC();
+	if (!reaper_open(&reaper)) crash("reaper_open");
 	memset(pids, 0, sizeof(pids));
 	system->clock.s = 0;
 	system->clock.ns = 0;
@@ -133,13 +157,17 @@ int main(int argc, char **argv) {
 	initSystem();
 	queue = queue_create();
 	initDescriptor();
+	if (pooled) createWorkerPool();
 
 	/* Start simulating */
 	simulate();
+	publishStats();
 
 	printSummary();
 
 	/* Cleanup resources */
+	releaseWorkerPool();
+	reaper_close(&reaper);
 	freeIPC();
 
 	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
@@ -184,15 +212,8 @@ void simulate() {
 		handleProcesses();
 		advanceClock();
 
-		/* Catch an exited user process */
-		int status;
-		pid_t pid = waitpid(-1, &status, WNOHANG);
-		if (pid > 0) {
-			int spid = WEXITSTATUS(status);
-			pids[spid] = 0;
-			activeCount--;
-			exitCount++;
-		}
+		/* Only look for exited user processes once one has said it's terminating, and sleep if that's all that's left */
+		if (exitPending > 0) reapProcesses(exitPending == activeCount && (quit || spawnCount >= PROCESSES_TOTAL));
 
 		/* Stop simulating if the last user process has exited */
 		if (quit) {
@@ -217,10 +238,10 @@ void handleProcesses() {
 		message.type = system->ptable[spid].pid;
 		message.spid = spid;
 		message.pid = system->ptable[spid].pid;
-		msgsnd(msqid, &message, sizeof(Message), 0);
+		msgsnd(msqid, &message, MESSAGE_SIZE, 0);
 
 		/* Receive a response of what they're doing */
-		msgrcv(msqid, &message, sizeof(Message), 1, 0);
+		msgrcv(msqid, &message, MESSAGE_SIZE, 1, 0);
 
 		switch (message.action) {
 			case TERMINATE:
@@ -245,6 +266,10 @@ void handleProcesses() {
 					log("none\n");
 				}
 				
+				/* A pooled user process goes back to waiting for a new simulated PID instead of exiting */
+				if (pooled) releaseWorker(spid);
+				else exitPending++;
+				
 				/* Remove user process from queue */
 				queue_remove(queue, spid);
 				next = queue->front;
@@ -264,6 +289,7 @@ void handleProcesses() {
 				}
 				log("\n");
 				
+				requestCount++;
 				bool isSafe = safe(queue, spid, message.request);
 				if (isSafe) {
 					n = 0;
@@ -275,18 +301,21 @@ void handleProcesses() {
 						message.request[i] = 0;
 					}
 					message.acquired = n > 0;
+					grantCount++;
 					log("Process P%d granted resources\n", message.spid);
 				} else {
 					message.acquired = false;
+					denyCount++;
 					log("Process P%d denied resources\n", message.spid);
 				}
 				
 				message.type = system->ptable[spid].pid;
-				msgsnd(msqid, &message, sizeof(Message), 0);
+				msgsnd(msqid, &message, MESSAGE_SIZE, 0);
 				
 				break;
 			case RELEASE:
 				log("%s: [%d.%d] Process P%d releasing resources\n", basename(programName), system->clock.s, system->clock.ns, message.spid);
+				releaseCount++;
 				
 				log("\tResources released: ");
 				n = 0;
@@ -309,6 +338,7 @@ void handleProcesses() {
 		}
 		
 		printDescriptor();
+		publishStats();
 		
 		/* Move on to the next user process */
 		if (message.action == TERMINATE) continue;
@@ -341,28 +371,79 @@ void trySpawnProcess() {
 }
 
 void spawnProcess(int spid) {
-	/* Fork a new user process */
-	pid_t pid = fork();
+	/* Hand the simulated PID to an idle pre-forked user process, or fork a new one */
+	pid_t pid = pooled ? assignWorker(spid) : forkUser(spid);
 
 	/* Record its PID */
 	pids[spid] = pid;
 
+	/* Since parent, initialize the new user process for simulation */
+	initPCB(pid, spid);
+	queue_push(queue, spid);
+	activeCount++;
+	spawnCount++;
+
+	log("%s: [%d.%d] Process P%d created\n", basename(programName), system->clock.s, system->clock.ns, spid);
+}
+
+/* Forks and executes a user process for the simulated PID, or a pooled user process if -1 */
+pid_t forkUser(int spid) {
+	/* Fork a new user process */
+	pid_t pid = fork();
+
 	if (pid == -1) crash("fork");
 	else if (pid == 0) {
 		/* Since child, execute a new user process */
 		char arg[BUFFER_LENGTH];
 		snprintf(arg, BUFFER_LENGTH, "%d", spid);
+		reaper_child(&reaper);
 		execl("./user", "user", arg, (char*) NULL);
 		crash("execl");
 	}
 
-	/* Since parent, initialize the new user process for simulation */
-	initPCB(pid, spid);
-	queue_push(queue, spid);
-	activeCount++;
-	spawnCount++;
+	return pid;
+}
 
-	log("%s: [%d.%d] Process P%d created\n", basename(programName), system->clock.s, system->clock.ns, spid);
+/* Forks every user process once, up front, so none are forked per simulated process */
+void createWorkerPool() {
+	int i;
+	for (i = 0; i < PROCESSES_MAX; i++) {
+		workers[i] = forkUser(-1);
+		pool[poolSize++] = workers[i];
+	}
+}
+
+void releaseWorkerPool() {
+	int i;
+
+	if (!pooled) return;
+
+	/* A simulated PID of -1 tells a pooled user process to exit */
+	for (i = 0; i < PROCESSES_MAX; i++) {
+		message.type = workers[i];
+		message.spid = -1;
+		msgsnd(msqid, &message, MESSAGE_SIZE, 0);
+	}
+	for (i = 0; i < PROCESSES_MAX; i++)
+		waitpid(workers[i], NULL, 0);
+}
+
+/* Sends an idle pooled user process the simulated PID it will now run as */
+pid_t assignWorker(int spid) {
+	pid_t pid = pool[--poolSize];
+	message.type = pid;
+	message.spid = spid;
+	message.pid = pid;
+	msgsnd(msqid, &message, MESSAGE_SIZE, 0);
+	return pid;
+}
+
+/* Returns a terminated simulated process' user process to the pool */
+void releaseWorker(int spid) {
+	pool[poolSize++] = pids[spid];
+	pids[spid] = 0;
+	activeCount--;
+	exitCount++;
 }
 
 void initPCB(pid_t pid, int spid) {
@@ -401,6 +482,39 @@ void advanceClock() {
 	semUnlock(0);
 }
 
+/* Reaps every user process that has exited, which SIGCHLD wakes us for, waiting for one first if asked to */
+void reapProcesses(bool wait) {
+	if (!reaper_wait(&reaper, wait ? -1 : 0)) return;
+	
+	int status;
+	pid_t pid;
+	while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+		int spid = WEXITSTATUS(status);
+		pids[spid] = 0;
+		activeCount--;
+		exitCount++;
+		exitPending--;
+	}
+	publishStats();
+}
+
+/* Copies the counters onto the stats page without ever waiting on ossstat, which retries if it reads mid-update */
+void publishStats() {
+	__atomic_store_n(&stats->sequence, stats->sequence + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	stats->clock = system->clock;
+	stats->spawned = spawnCount;
+	stats->exited = exitCount;
+	stats->active = activeCount;
+	stats->requests = requestCount;
+	stats->grants = grantCount;
+	stats->denials = denyCount;
+	stats->releases = releaseCount;
+
+	__atomic_store_n(&stats->sequence, stats->sequence + 1, __ATOMIC_RELEASE);
+}
+
 bool safe(Queue *queue, int index, int request[RESOURCES_MAX]) {
 	int i, j, k, p;
 
@@ -549,8 +663,9 @@ void init(int argc, char **argv) {
 void usage(int status) {
 	if (status != EXIT_SUCCESS) fprintf(stderr, "Try '%s -h' for more information\n", programName);
 	else {
-		printf("Usage: %s [-v]\n", programName);
+		printf("Usage: %s [-v] [-w]\n", programName);
 		printf("   v : Verbose mode (default off)\n");
+		printf("   w : Pre-fork a pool of reusable user processes (default off)\n");
 	}
 	exit(status);
 }
@@ -615,9 +730,23 @@ void initIPC() {
 	if ((key = ftok(KEY_PATHNAME, KEY_ID_SEMAPHORE)) == -1) crash("ftok");
 	if ((semid = semget(key, 1, IPC_EXCL | IPC_CREAT | PERMS)) == -1) crash("semget");
 	if (semctl(semid, 0, SETVAL, 1) == -1) crash("semctl");
+
+	if ((key = ftok(KEY_PATHNAME, KEY_ID_STATS)) == -1) crash("ftok");
+	if ((statsid = shmget(key, sizeof(Stats), IPC_EXCL | IPC_CREAT | PERMS)) == -1) crash("shmget");
+	if ((stats = (Stats*) shmat(statsid, NULL, 0)) == (void*) -1) crash("shmat");
+	memset(stats, 0, sizeof(Stats));
+	stats->version = STATS_VERSION;
 }
 
 void freeIPC() {
+	/* Let ossstat know nothing more is coming before the page goes away */
+	if (stats != NULL) {
+		__atomic_store_n(&stats->finished, true, __ATOMIC_RELEASE);
+		if (shmdt(stats) == -1) crash("shmdt");
+		stats = NULL;
+	}
+	if (statsid > 0 && shmctl(statsid, IPC_RMID, NULL) == -1) crash("shmctl");
+
 	if (system != NULL && shmdt(system) == -1) crash("shmdt");
 	if (shmid > 0 && shmctl(shmid, IPC_RMID, NULL) == -1) crash("shmdt");
 
@@ -0,0 +1,143 @@
+/*
+ * ossstat.c November 21, 2020
+ * Jared Diehl (jmddnb@umsystem.edu)
+ */
+
+#include <sched.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "shared.h"
+
+void init(int, char**);
+void usage(int);
+void initIPC();
+void freeIPC();
+void readStats(Stats*);
+void printHeader();
+void printLine(Stats*, Stats*);
+void crash(char*);
+
+static char *programName;
+
+/* IPC variables */
+static int statsid = -1;
+static Stats *stats = NULL;
+
+int main(int argc, char **argv) {
+	init(argc, argv);
+
+	/* Get program arguments */
+	while (true) {
+		int c = getopt(argc, argv, "h");
+		if (c == -1) break;
+		switch (c) {
+			case 'h':
+				usage(EXIT_SUCCESS);
+			default:
+				usage(EXIT_FAILURE);
+		}
+	}
+
+	int interval = 1, count = 0;
+	if (optind < argc && (interval = atoi(argv[optind++])) < 1) usage(EXIT_FAILURE);
+	if (optind < argc && (count = atoi(argv[optind++])) < 1) usage(EXIT_FAILURE);
+
+	initIPC();
+
+	/* The first line counts everything since OSS started */
+	Stats previous, current;
+	memset(&previous, 0, sizeof(Stats));
+
+	printHeader();
+	int i;
+	for (i = 0; count == 0 || i < count; i++) {
+		if (i > 0) sleep(interval);
+		readStats(&current);
+		printLine(&previous, &current);
+		previous = current;
+		if (current.finished) break;
+	}
+
+	freeIPC();
+
+	return EXIT_SUCCESS;
+}
+
+void init(int argc, char **argv) {
+	programName = argv[0];
+
+	setvbuf(stdout, NULL, _IONBF, 0);
+	setvbuf(stderr, NULL, _IONBF, 0);
+}
+
+void usage(int status) {
+	if (status != EXIT_SUCCESS) fprintf(stderr, "Try '%s -h' for more information\n", programName);
+	else {
+		printf("Usage: %s [interval [count]]\n", programName);
+		printf("   interval : Seconds between lines (default 1)\n");
+		printf("   count    : Lines before exiting (default until OSS is done)\n");
+	}
+	exit(status);
+}
+
+/* Attaches read-only to the page OSS publishes, so there's nothing here that could disturb it */
+void initIPC() {
+	key_t key;
+
+	if ((key = ftok(KEY_PATHNAME, KEY_ID_STATS)) == -1) crash("ftok");
+	if ((statsid = shmget(key, sizeof(Stats), 0)) == -1) crash("shmget");
+	if ((stats = (Stats*) shmat(statsid, NULL, SHM_RDONLY)) == (void*) -1) crash("shmat");
+
+	if (stats->version != STATS_VERSION) {
+		fprintf(stderr, "%s: stats page is version %u, expected %u\n", programName, stats->version, STATS_VERSION);
+		exit(EXIT_FAILURE);
+	}
+}
+
+void freeIPC() {
+	if (stats != NULL && shmdt(stats) == -1) crash("shmdt");
+}
+
+/* Copies out a consistent snapshot, retrying whenever OSS was writing in the meantime */
+void readStats(Stats *snapshot) {
+	unsigned int before, after;
+	do {
+		while ((before = __atomic_load_n(&stats->sequence, __ATOMIC_ACQUIRE)) & 1) sched_yield();
+		memcpy(snapshot, stats, sizeof(Stats));
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		after = __atomic_load_n(&stats->sequence, __ATOMIC_RELAXED);
+	} while (before != after);
+}
+
+void printHeader() {
+	printf("%-16s %7s %7s %7s %8s %7s %7s %8s\n", "clock", "spawned", "exited", "active", "requests", "grants", "denials", "releases");
+}
+
+/* Counters show how much they went up since the line before, the clock and active processes as they are */
+void printLine(Stats *previous, Stats *current) {
+	char clock[BUFFER_LENGTH];
+	snprintf(clock, BUFFER_LENGTH, "%u.%u", current->clock.s, current->clock.ns);
+	printf("%-16s %7u %7u %7u %8u %7u %7u %8u\n", clock,
+			current->spawned - previous->spawned,
+			current->exited - previous->exited,
+			current->active,
+			current->requests - previous->requests,
+			current->grants - previous->grants,
+			current->denials - previous->denials,
+			current->releases - previous->releases);
+}
+
+void crash(char *msg) {
+	char buf[BUFFER_LENGTH];
+	snprintf(buf, BUFFER_LENGTH, "%s: %s", programName, msg);
+	perror(buf);
+
+	exit(EXIT_FAILURE);
+}
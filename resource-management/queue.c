@@ -37,14 +37,13 @@ void queue_push(Queue *queue, int index) {
 	queue->rear = node;
 }
 
-QueueNode *queue_pop(Queue *queue) {
-	if (queue->front == NULL) return NULL;
+void queue_pop(Queue *queue) {
+	if (queue->front == NULL) return;
 	QueueNode *temp = queue->front;
-	free(temp);
 	queue->front = queue->front->next;
 	if (queue->front == NULL) queue->rear = NULL;
 	queue->count--;
-	return temp;
+	free(temp);
 }
 
 void queue_remove(Queue *queue, int index) {
@@ -22,7 +22,7 @@ typedef struct {
 Queue *queue_create();
 QueueNode *queue_node(int);
 void queue_push(Queue*, int);
-QueueNode *queue_pop(Queue*);
+void queue_pop(Queue*);
 void queue_remove(Queue*, int);
 bool queue_empty(Queue*);
 int queue_size(Queue*);
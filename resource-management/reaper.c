@@ -0,0 +1,48 @@
+/*
+ * reaper.c November 21, 2020
+ * Jared Diehl (jmddnb@umsystem.edu)
+ */
+
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <unistd.h>
+
+#include "reaper.h"
+
+/* Blocks SIGCHLD so it's only ever read from the signalfd, which has to happen before any child is forked */
+bool reaper_open(Reaper *reaper) {
+	sigset_t mask;
+	sigemptyset(&mask);
+	sigaddset(&mask, SIGCHLD);
+	if (sigprocmask(SIG_BLOCK, &mask, &reaper->previous) == -1) return false;
+	
+	if ((reaper->sigfd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC)) == -1) return false;
+	if ((reaper->epfd = epoll_create1(EPOLL_CLOEXEC)) == -1) return false;
+	
+	struct epoll_event event = { .events = EPOLLIN, .data.fd = reaper->sigfd };
+	return epoll_ctl(reaper->epfd, EPOLL_CTL_ADD, reaper->sigfd, &event) != -1;
+}
+
+/*
+ * Waits up to the timeout in milliseconds, or forever if -1, for a child to have exited, returning whether one has.
+ * Signals of children that exit together are merged into one, so the caller should reap until there's none left.
+ */
+bool reaper_wait(Reaper *reaper, int timeout) {
+	struct epoll_event event;
+	if (epoll_wait(reaper->epfd, &event, 1, timeout) < 1) return false;
+	
+	struct signalfd_siginfo info;
+	while (read(reaper->sigfd, &info, sizeof(info)) == sizeof(info));
+	return true;
+}
+
+/* Gives a forked child back the signal mask it would have had */
+void reaper_child(Reaper *reaper) {
+	sigprocmask(SIG_SETMASK, &reaper->previous, NULL);
+}
+
+void reaper_close(Reaper *reaper) {
+	close(reaper->epfd);
+	close(reaper->sigfd);
+	sigprocmask(SIG_SETMASK, &reaper->previous, NULL);
+}
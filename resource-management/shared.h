@@ -20,9 +20,11 @@
 #define KEY_ID_SYSTEM 0
 #define KEY_ID_MESSAGE_QUEUE 1
 #define KEY_ID_SEMAPHORE 2
+#define KEY_ID_STATS 3
 #define PERMS (S_IRUSR | S_IWUSR)
 
 #define PATH_LOG "output.log"
+#define STATS_VERSION 1
 #define TIMEOUT 5
 #define PROCESSES_MAX 18
 #define PROCESSES_TOTAL 40
@@ -46,6 +48,9 @@ typedef struct {
 	bool acquired;
 } Message;
 
+/* Size of a message minus its type, which is what msgsnd and msgrcv expect */
+#define MESSAGE_SIZE (sizeof(Message) - sizeof(long))
+
 typedef struct {
 	int resource[RESOURCES_MAX];
 	int shared[RESOURCES_MAX];
@@ -63,4 +68,19 @@ typedef struct {
 	PCB ptable[PROCESSES_MAX];
 } System;
 
+/* Counters OSS publishes for ossstat, guarded by a sequence that's odd while OSS is writing */
+typedef struct {
+	unsigned int version;
+	unsigned int sequence;
+	bool finished;
+	Time clock;
+	unsigned int spawned;
+	unsigned int exited;
+	unsigned int active;
+	unsigned int requests;
+	unsigned int grants;
+	unsigned int denials;
+	unsigned int releases;
+} Stats;
+
 #endif
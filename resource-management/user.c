@@ -25,6 +25,7 @@
 #include "shared.h"
 
 void init(int, char**);
+void simulate(int);
 void registerSignalHandlers();
 void signalHandler(int);
 void initIPC();
@@ -47,16 +48,37 @@ int main(int argc, char **argv) {
 
 	initIPC();
 
+	/* Run as the given simulated PID, or as a pooled user process if -1 */
+	if (spid != -1) {
+		simulate(spid);
+		return spid;
+	}
+
+	while (true) {
+		/* Wait until OSS assigns us a simulated PID, where -1 means we're no longer needed */
+		msgrcv(msqid, &message, MESSAGE_SIZE, getpid(), 0);
+		if (message.spid == -1) break;
+		simulate(message.spid);
+	}
+
+	return EXIT_SUCCESS;
+}
+
+/* Runs the decision loop as a simulated process until it terminates */
+void simulate(int spid) {
 	Time start;
 	Time end;
 	bool canTerminate = false;
 	bool hasResources = false;
 	int i;
+
+	start.s = system->clock.s;
+	start.ns = system->clock.ns;
 	
 	/* Decision loop */
 	while (true) {
 		/* Wait until we get a message from OSS telling us it's our turn to "run" */
-		msgrcv(msqid, &message, sizeof(Message), getpid(), 0);
+		msgrcv(msqid, &message, MESSAGE_SIZE, getpid(), 0);
 		
 		if (!canTerminate) {
 			end.s = system->clock.s;
@@ -77,25 +99,23 @@ int main(int argc, char **argv) {
 				message.action = REQUEST;
 				for (i = 0; i < RESOURCES_MAX; i++)
 					message.request[i] = rand() % (system->ptable[spid].maximum[i] - system->ptable[spid].allocation[i] + 1);
-				msgsnd(msqid, &message, sizeof(Message), 0);
-				msgrcv(msqid, &message, sizeof(Message), getpid(), 0);
+				msgsnd(msqid, &message, MESSAGE_SIZE, 0);
+				msgrcv(msqid, &message, MESSAGE_SIZE, getpid(), 0);
 				if (message.acquired) hasResources = true;
 				message.acquired = false;
 				break;
 			case 1:
 				message.type = 1;
 				message.action = RELEASE;
-				msgsnd(msqid, &message, sizeof(Message), 0);
+				msgsnd(msqid, &message, MESSAGE_SIZE, 0);
 				break;
 			case 2:
 				message.type = 1;
 				message.action = TERMINATE;
-				msgsnd(msqid, &message, sizeof(Message), 0);
-				exit(spid);
+				msgsnd(msqid, &message, MESSAGE_SIZE, 0);
+				return;
 		}
 	}
-	
-	return spid;
 }
 
 void init(int argc, char **argv) {